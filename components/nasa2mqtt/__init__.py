@@ -1,14 +1,22 @@
+import fnmatch
+import re
+from pathlib import Path
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart, sensor, switch, select, number, climate
+from esphome.components import uart, sensor, switch, select, number, climate, web_server_base
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
+from esphome.components.esp32 import add_idf_sdkconfig_option
 from esphome.const import (
-    CONF_ID
+    CONF_ID,
+    CONF_PATH
 )
 from esphome.core import CORE
 
+DOMAIN = "nasa2mqtt"
 CODEOWNERS = ["foxhill67"]
 DEPENDENCIES = ["uart"]
-MULTI_CONF = False
+MULTI_CONF = True
 
 CONF_NASA2MQTT_ID = "nasa2mqtt_id"
 
@@ -16,16 +24,246 @@ nasa2mqtt = cg.esphome_ns.namespace("nasa2mqtt")
 NASA2MQTT = nasa2mqtt.class_(
     "NASA2MQTT", cg.PollingComponent, uart.UARTDevice
 )
+MessageGroup = nasa2mqtt.enum("MessageGroup", is_class=True)
+RuleCondition = nasa2mqtt.enum("RuleCondition", is_class=True)
+MESSAGE_GROUPS = {
+    "address": MessageGroup.Address,
+    "network": MessageGroup.Network,
+    "indoor": MessageGroup.Indoor,
+    "outdoor": MessageGroup.Outdoor,
+    "fsv": MessageGroup.Fsv,
+}
 
 CONF_MQTT_HOST = "mqtt_host"
 CONF_MQTT_PORT = "mqtt_port"
 CONF_MQTT_USERNAME = "mqtt_username"
 CONF_MQTT_PASSWORD = "mqtt_password"
+CONF_MQTT_CA_CERTIFICATE = "mqtt_ca_certificate"
+CONF_MQTT_SSL_FINGERPRINT = "mqtt_ssl_fingerprint"
+CONF_MQTT_CLIENT_ID = "mqtt_client_id"
+CONF_MQTT_CLEAN_SESSION = "mqtt_clean_session"
+CONF_MQTT_INFLIGHT_WINDOW = "mqtt_inflight_window"
+CONF_MQTT_RETRANSMIT_TIMEOUT = "mqtt_retransmit_timeout"
+CONF_TOPIC_PREFIX = "topic_prefix"
+
+CONF_REQUEST_MESSAGES = "request_messages"
+CONF_REQUEST_INTERVAL = "request_interval"
+CONF_REQUEST_BATCH_SIZE = "request_batch_size"
+CONF_WRITE_MESSAGES = "write_messages"
+CONF_RATE_LIMITS = "rate_limits"
+CONF_MESSAGE = "message"
+CONF_GROUP = "group"
+CONF_INTERVAL = "interval"
+CONF_BURST = "burst"
+CONF_AGGREGATES = "aggregates"
+CONF_WINDOWS = "windows"
+CONF_PUBLISH_RAW = "publish_raw"
+CONF_DERIVED_METRICS = "derived_metrics"
+CONF_MESSAGES = "messages"
+CONF_INCLUDE = "include"
+CONF_EXCLUDE = "exclude"
+CONF_METRICS = "metrics"
+CONF_RULES = "rules"
+CONF_NAME = "name"
+CONF_ABOVE = "above"
+CONF_BELOW = "below"
+CONF_EQUALS = "equals"
+CONF_CHANGE = "change"
+CONF_FROM = "from"
+CONF_TO = "to"
+CONF_HYSTERESIS = "hysteresis"
+CONF_FOR = "for"
+CONF_HISTORY = "history"
+CONF_SIZE = "size"
+CONF_DISCOVERY = "discovery"
+CONF_PREFIX = "prefix"
+CONF_STATE_DOCUMENTS = "state_documents"
+CONF_DELTA_INTERVAL = "delta_interval"
+CONF_FRAME_DEDUP = "frame_dedup"
+CONF_MAX_AGE = "max_age"
 
 CONF_DEBUG_LOG_MESSAGES = "debug_log_messages"
 CONF_DEBUG_LOG_MESSAGES_RAW = "debug_log_messages_raw"
 
-CONFIG_SCHEMA = (
+def validate_ssl_fingerprint(value):
+    value = cv.string(value).replace(":", "").lower()
+    if not re.fullmatch(r"[0-9a-f]{40}", value):
+        raise cv.Invalid("the SHA-1 fingerprint of the broker certificate has 40 hex digits")
+    return value
+
+
+def validate_mqtt_session(config):
+    if not config[CONF_MQTT_CLEAN_SESSION] and not config[CONF_MQTT_CLIENT_ID]:
+        raise cv.Invalid(f"{CONF_MQTT_CLEAN_SESSION}: false needs a fixed {CONF_MQTT_CLIENT_ID}, "
+                         "the broker keeps the session under it")
+    return config
+
+
+RATE_LIMIT_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_MESSAGE): cv.hex_uint16_t,
+            cv.Optional(CONF_GROUP): cv.enum(MESSAGE_GROUPS, lower=True),
+            cv.Required(CONF_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_BURST, default=1): cv.int_range(min=1, max=100),
+        }
+    ),
+    cv.has_exactly_one_key(CONF_MESSAGE, CONF_GROUP),
+)
+
+AGGREGATE_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_MESSAGE): cv.hex_uint16_t,
+        cv.Optional(CONF_WINDOWS, default=["60s"]): cv.ensure_list(
+            cv.All(cv.positive_time_period_milliseconds,
+                   cv.Range(min=cv.TimePeriod(seconds=1)))),
+        cv.Optional(CONF_PUBLISH_RAW, default=False): cv.boolean,
+    }
+)
+
+
+def load_catalog():
+    """(name, number, group) for every catalog.cpp entry, in catalog order"""
+    here = Path(__file__).parent
+    numbers = dict(re.findall(r"(\w+) = (0x[0-9A-Fa-f]+)",
+                   (here / "nasa.h").read_text()))
+    entries = re.findall(r"\{MessageNumber::(\w+), MessageGroup::(\w+),",
+                         (here / "catalog.cpp").read_text())
+    return [(name, int(numbers[name], 16), group.lower()) for name, group in entries]
+
+
+def select_messages(catalog, selectors):
+    """Indices of catalog entries matching any selector: a message number,
+    a group name or a name pattern like VAR_OUT_SENSOR_*"""
+    selected = set()
+    for selector in selectors:
+        matches = [
+            index for index, (name, number, group) in enumerate(catalog)
+            if selector == number
+            or (isinstance(selector, str) and (selector.lower() == group or
+                                               fnmatch.fnmatchcase(name, selector.upper())))
+        ]
+        if not matches:
+            raise cv.Invalid(f"'{selector}' does not match any message")
+        selected.update(matches)
+    return selected
+
+
+def validate_messages(config):
+    catalog = load_catalog()
+    select_messages(catalog, config.get(CONF_INCLUDE, []))
+    select_messages(catalog, config[CONF_EXCLUDE])
+    return config
+
+
+def validate_rule_message(value):
+    value = cv.hex_uint16_t(value)
+    if value not in {number for name, number, group in load_catalog()}:
+        raise cv.Invalid(f"message 0x{value:04X} is not in the catalog")
+    return value
+
+
+def validate_rule(config):
+    if CONF_CHANGE in config and (CONF_HYSTERESIS in config or CONF_FOR in config):
+        raise cv.Invalid("change rules take neither hysteresis nor for")
+    if CONF_EQUALS in config and CONF_HYSTERESIS in config:
+        raise cv.Invalid("equals rules take no hysteresis")
+    return config
+
+
+RULE_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            # topic <prefix>/events/<name>
+            cv.Required(CONF_NAME): cv.All(cv.string_strict, cv.Length(min=1)),
+            cv.Required(CONF_MESSAGE): validate_rule_message,
+            cv.Optional(CONF_ABOVE): cv.int_,
+            cv.Optional(CONF_BELOW): cv.int_,
+            cv.Optional(CONF_EQUALS): cv.int_,
+            cv.Optional(CONF_CHANGE): cv.Schema(
+                {
+                    cv.Optional(CONF_FROM): cv.int_,
+                    cv.Optional(CONF_TO): cv.int_,
+                }
+            ),
+            cv.Optional(CONF_HYSTERESIS): cv.int_range(min=0),
+            cv.Optional(CONF_FOR): cv.positive_time_period_milliseconds,
+        }
+    ),
+    cv.has_exactly_one_key(CONF_ABOVE, CONF_BELOW, CONF_EQUALS, CONF_CHANGE),
+    validate_rule,
+)
+
+
+def validate_history_message(value):
+    value = validate_rule_message(value)
+    if (value >> 9) & 3 == 3:
+        raise cv.Invalid(f"message 0x{value:04X} is a structure, it has no value to record")
+    return value
+
+
+HISTORY_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_MESSAGE): validate_history_message,
+        # bytes of samples kept, in blocks of 128
+        cv.Optional(CONF_SIZE, default=1024): cv.int_range(min=256, max=65536),
+        # minimum time between two recorded samples
+        cv.Optional(CONF_INTERVAL, default="60s"): cv.All(cv.positive_time_period_milliseconds,
+                                                          cv.Range(min=cv.TimePeriod(seconds=1))),
+    }
+)
+
+DISCOVERY_SCHEMA = cv.Schema(
+    {
+        # discovery prefix Home Assistant listens on
+        cv.Optional(CONF_PREFIX, default="homeassistant"): cv.All(cv.string_strict, cv.Length(min=1)),
+        # one config every interval, after a burst of up to burst configs
+        cv.Optional(CONF_INTERVAL, default="1s"): cv.All(cv.positive_time_period_milliseconds,
+                                                         cv.Range(min=cv.TimePeriod(milliseconds=1))),
+        cv.Optional(CONF_BURST, default=5): cv.int_range(min=1, max=50),
+    }
+)
+
+STATE_DOCUMENTS_SCHEMA = cv.Schema(
+    {
+        # full retained document per device
+        cv.Optional(CONF_INTERVAL, default="60s"): cv.All(cv.positive_time_period_milliseconds,
+                                                          cv.Range(min=cv.TimePeriod(seconds=1))),
+        # values changed since that document, at most this often
+        cv.Optional(CONF_DELTA_INTERVAL, default="5s"): cv.All(cv.positive_time_period_milliseconds,
+                                                               cv.Range(min=cv.TimePeriod(milliseconds=100))),
+    }
+)
+
+FRAME_DEDUP_SCHEMA = cv.Schema(
+    {
+        # a repeated notification still goes through when its kind was last processed this long ago
+        cv.Optional(CONF_MAX_AGE, default="60s"): cv.All(cv.positive_time_period_milliseconds,
+                                                         cv.Range(min=cv.TimePeriod(seconds=1))),
+    }
+)
+
+METRICS_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(web_server_base.WebServerBase),
+        # shared by all buses, the first one decides
+        cv.Optional(CONF_PATH, default="/metrics"): cv.string_strict,
+    }
+)
+
+MESSAGE_SELECTOR = cv.Any(cv.int_, cv.string)
+
+MESSAGES_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_INCLUDE): cv.ensure_list(MESSAGE_SELECTOR),
+            cv.Optional(CONF_EXCLUDE, default=[]): cv.ensure_list(MESSAGE_SELECTOR),
+        }
+    ),
+    validate_messages,
+)
+
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(NASA2MQTT),
@@ -33,12 +271,37 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_MQTT_PORT, default=1883): cv.int_,
             cv.Optional(CONF_MQTT_USERNAME, default=""): cv.string,
             cv.Optional(CONF_MQTT_PASSWORD, default=""): cv.string,
+            # TLS: the CA certificate (PEM) on the ESP32, the broker certificate fingerprint on the ESP8266
+            cv.Optional(CONF_MQTT_CA_CERTIFICATE): cv.All(cv.only_on_esp32, cv.string),
+            cv.Optional(CONF_MQTT_SSL_FINGERPRINT): cv.All(cv.only_on_esp8266, validate_ssl_fingerprint),
+            cv.Optional(CONF_MQTT_CLIENT_ID, default=""): cv.string,
+            cv.Optional(CONF_MQTT_CLEAN_SESSION, default=True): cv.boolean,
+            cv.Optional(CONF_MQTT_INFLIGHT_WINDOW, default=8): cv.int_range(min=1, max=32),
+            cv.Optional(CONF_MQTT_RETRANSMIT_TIMEOUT, default="5s"): cv.All(
+                cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(milliseconds=100))),
+            # one per bus when there is more than one, all buses share the MQTT client
+            cv.Optional(CONF_TOPIC_PREFIX, default="samsung_ehs"): cv.All(cv.string_strict, cv.Length(min=1)),
+            cv.Optional(CONF_REQUEST_MESSAGES, default=[]): cv.ensure_list(cv.hex_uint16_t),
+            cv.Optional(CONF_REQUEST_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_REQUEST_BATCH_SIZE, default=10): cv.int_range(min=1, max=50),
+            cv.Optional(CONF_WRITE_MESSAGES, default=[]): cv.ensure_list(cv.hex_uint16_t),
+            cv.Optional(CONF_RATE_LIMITS, default=[]): cv.ensure_list(RATE_LIMIT_SCHEMA),
+            cv.Optional(CONF_AGGREGATES, default=[]): cv.ensure_list(AGGREGATE_SCHEMA),
+            cv.Optional(CONF_DERIVED_METRICS, default=False): cv.boolean,
+            cv.Optional(CONF_MESSAGES): MESSAGES_SCHEMA,
+            cv.Optional(CONF_METRICS): METRICS_SCHEMA,
+            cv.Optional(CONF_RULES, default=[]): cv.ensure_list(RULE_SCHEMA),
+            cv.Optional(CONF_HISTORY, default=[]): cv.ensure_list(HISTORY_SCHEMA),
+            cv.Optional(CONF_DISCOVERY): DISCOVERY_SCHEMA,
+            cv.Optional(CONF_STATE_DOCUMENTS): STATE_DOCUMENTS_SCHEMA,
+            cv.Optional(CONF_FRAME_DEDUP): FRAME_DEDUP_SCHEMA,
             cv.Optional(CONF_DEBUG_LOG_MESSAGES, default=False): cv.boolean,
             cv.Optional(CONF_DEBUG_LOG_MESSAGES_RAW, default=False): cv.boolean
         }
     )
     .extend(uart.UART_DEVICE_SCHEMA)
-    .extend(cv.polling_component_schema("30s"))
+    .extend(cv.polling_component_schema("30s")),
+    validate_mqtt_session,
 )
 
 
@@ -47,10 +310,108 @@ async def to_code(config):
     if CORE.is_esp8266 or CORE.is_libretiny:
         cg.add_library("heman/AsyncMqttClient-esphome", "2.0.0")
 
+    # the catalog is shared by all buses, so it is compiled once for the union of their selections
+    buses = CORE.config[DOMAIN]
+    if not CORE.data.setdefault(DOMAIN, {}).get(CONF_MESSAGES) and all(CONF_MESSAGES in bus for bus in buses):
+        CORE.data[DOMAIN][CONF_MESSAGES] = True
+        catalog = load_catalog()
+        selected = set()
+        numbers = [number for name, number, group in catalog]
+        for bus in buses:
+            # rules and history need their messages decoded, whatever is published
+            selected |= {numbers.index(rule[CONF_MESSAGE]) for rule in bus[CONF_RULES]}
+            selected |= {numbers.index(series[CONF_MESSAGE]) for series in bus[CONF_HISTORY]}
+            messages = bus[CONF_MESSAGES]
+            included = select_messages(catalog, messages[CONF_INCLUDE]) if CONF_INCLUDE in messages \
+                else set(range(len(catalog)))
+            selected |= included - select_messages(catalog, messages[CONF_EXCLUDE])
+        # 256 bits per high byte of a selected message number, so the filter is small and a lookup
+        # by message number needs no search; an empty selection still gets a page, all zero
+        pages = sorted({numbers[index] >> 8 for index in selected}) or [0]
+        words = [0] * (8 * len(pages))
+        for index in selected:
+            number = numbers[index]
+            words[8 * pages.index(number >> 8) + (number & 0xFF) // 32] |= 1 << (number % 32)
+        cg.add_define("NASA2MQTT_MESSAGE_PAGES", cg.RawExpression(
+            ", ".join(f"0x{page:02X}" for page in pages)))
+        cg.add_define("NASA2MQTT_MESSAGE_FILTER", cg.RawExpression(
+            ", ".join(f"0x{word:08X}u" for word in words)))
+
     var = cg.new_Pvariable(config[CONF_ID])
 
     cg.add(var.set_mqtt(config[CONF_MQTT_HOST], config[CONF_MQTT_PORT],
            config[CONF_MQTT_USERNAME], config[CONF_MQTT_PASSWORD]))
+    if CONF_MQTT_CA_CERTIFICATE in config:
+        cg.add(var.set_mqtt_tls(config[CONF_MQTT_CA_CERTIFICATE]))
+        if CORE.using_esp_idf:
+            # reconnects offer the ticket of the previous session instead of a full handshake
+            add_idf_sdkconfig_option("CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS", True)
+    if CONF_MQTT_SSL_FINGERPRINT in config:
+        cg.add_build_flag("-DASYNC_TCP_SSL_ENABLED=1")
+        cg.add(var.set_mqtt_tls(config[CONF_MQTT_SSL_FINGERPRINT]))
+    cg.add(var.set_mqtt_session(config[CONF_MQTT_CLIENT_ID], config[CONF_MQTT_CLEAN_SESSION]))
+    cg.add(var.set_mqtt_inflight(config[CONF_MQTT_INFLIGHT_WINDOW], config[CONF_MQTT_RETRANSMIT_TIMEOUT]))
+
+    cg.add(var.set_topic_prefix(config[CONF_TOPIC_PREFIX]))
+
+    for message in config[CONF_REQUEST_MESSAGES]:
+        cg.add(var.add_request_message(message))
+    cg.add(var.set_request_interval(
+        config[CONF_REQUEST_INTERVAL].total_milliseconds))
+    cg.add(var.set_request_batch_size(config[CONF_REQUEST_BATCH_SIZE]))
+    for message in config[CONF_WRITE_MESSAGES]:
+        cg.add(var.add_write_message(message))
+
+    # group limits first, so a limit for a single message overrides its group
+    for limit in sorted(config[CONF_RATE_LIMITS], key=lambda limit: CONF_MESSAGE in limit):
+        target = limit[CONF_MESSAGE] if CONF_MESSAGE in limit else limit[CONF_GROUP]
+        cg.add(var.add_rate_limit(target,
+               limit[CONF_INTERVAL].total_milliseconds, limit[CONF_BURST]))
+
+    for aggregate in config[CONF_AGGREGATES]:
+        for window in aggregate[CONF_WINDOWS]:
+            cg.add(var.add_aggregate(
+                aggregate[CONF_MESSAGE], window.total_milliseconds))
+        cg.add(var.set_aggregate_publish_raw(
+            aggregate[CONF_MESSAGE], aggregate[CONF_PUBLISH_RAW]))
+
+    cg.add(var.set_derived_metrics(config[CONF_DERIVED_METRICS]))
+
+    for rule in config[CONF_RULES]:
+        if CONF_CHANGE in rule:
+            change = rule[CONF_CHANGE]
+            cg.add(var.add_change_rule(rule[CONF_NAME], rule[CONF_MESSAGE],
+                   CONF_FROM in change, change.get(CONF_FROM, 0),
+                   CONF_TO in change, change.get(CONF_TO, 0)))
+            continue
+        for key, condition in ((CONF_ABOVE, RuleCondition.Above), (CONF_BELOW, RuleCondition.Below),
+                               (CONF_EQUALS, RuleCondition.Equals)):
+            if key in rule:
+                duration = rule[CONF_FOR].total_milliseconds if CONF_FOR in rule else 0
+                cg.add(var.add_rule(rule[CONF_NAME], rule[CONF_MESSAGE], condition,
+                       rule[key], rule.get(CONF_HYSTERESIS, 0), duration))
+
+    for series in config[CONF_HISTORY]:
+        cg.add(var.add_history(series[CONF_MESSAGE], series[CONF_SIZE],
+               series[CONF_INTERVAL].total_milliseconds // 1000))
+
+    if CONF_DISCOVERY in config:
+        discovery = config[CONF_DISCOVERY]
+        cg.add(var.set_discovery(discovery[CONF_PREFIX], discovery[CONF_INTERVAL].total_milliseconds,
+               discovery[CONF_BURST]))
+
+    if CONF_STATE_DOCUMENTS in config:
+        states = config[CONF_STATE_DOCUMENTS]
+        cg.add(var.set_state_documents(states[CONF_INTERVAL].total_milliseconds,
+               states[CONF_DELTA_INTERVAL].total_milliseconds))
+
+    if CONF_FRAME_DEDUP in config:
+        cg.add(var.set_frame_dedup(config[CONF_FRAME_DEDUP][CONF_MAX_AGE].total_milliseconds))
+
+    if CONF_METRICS in config:
+        cg.add_define("USE_NASA2MQTT_METRICS")
+        base = await cg.get_variable(config[CONF_METRICS][CONF_WEB_SERVER_BASE_ID])
+        cg.add(var.set_metrics(base, config[CONF_METRICS][CONF_PATH]))
 
     if (CONF_DEBUG_LOG_MESSAGES in config):
         cg.add(var.set_debug_log_messages(config[CONF_DEBUG_LOG_MESSAGES]))
@@ -0,0 +1,94 @@
+#include "aggregator.h"
+#include "util.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        void Aggregator::add_series(MessageNumber messageNumber, uint32_t window)
+        {
+            const MessageInfo *info = find_message_info(messageNumber);
+            if (info == nullptr || window == 0)
+                return;
+
+            if (series_of_.empty())
+            {
+                series_of_.resize(catalog_size(), NO_SERIES);
+                publish_raw_.resize(catalog_size(), true);
+            }
+
+            size_t index = catalog_index(*info);
+            Series series = {};
+            series.window = window;
+            series.index = index;
+            series.next = series_of_[index];
+            series_of_[index] = series_.size();
+            series_.push_back(series);
+            publish_raw_[index] = false;
+        }
+
+        void Aggregator::set_publish_raw(MessageNumber messageNumber, bool publish_raw)
+        {
+            const MessageInfo *info = find_message_info(messageNumber);
+            if (info == nullptr || publish_raw_.empty())
+                return;
+
+            publish_raw_[catalog_index(*info)] = publish_raw;
+        }
+
+        bool Aggregator::add(const MessageInfo &info, long value, uint32_t now)
+        {
+            if (series_of_.empty())
+                return true;
+
+            size_t index = catalog_index(info);
+            for (uint16_t i = series_of_[index]; i != NO_SERIES; i = series_[i].next)
+            {
+                Series &series = series_[i];
+                if (series.count == 0)
+                {
+                    if (series.window_start == 0)
+                        series.window_start = now;
+                    series.min = value;
+                    series.max = value;
+                }
+                else
+                {
+                    if (value < series.min)
+                        series.min = value;
+                    if (value > series.max)
+                        series.max = value;
+                }
+                series.sum += value;
+                series.count++;
+            }
+            return publish_raw_[index];
+        }
+
+        void Aggregator::flush(uint32_t now, const SummaryCallback &callback)
+        {
+            for (auto &series : series_)
+            {
+                if (series.window_start == 0 || now - series.window_start < series.window)
+                    continue;
+
+                if (series.count > 0)
+                {
+                    char payload[96];
+                    // int32_t is long on ESP-IDF 5
+                    sprintf(payload, "{\"min\":%d,\"max\":%d,\"avg\":%.2f,\"count\":%u}", (int)series.min, (int)series.max,
+                            (double)series.sum / series.count, (unsigned)series.count);
+                    callback(long_to_hex((uint16_t)catalog_entry(series.index).messageNumber) + "/window_" +
+                                 std::to_string(series.window / 1000) + "s",
+                             payload);
+                }
+
+                // windows stay aligned to the first sample, even when the loop was late
+                series.window_start += (now - series.window_start) / series.window * series.window;
+                series.sum = 0;
+                series.count = 0;
+            }
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
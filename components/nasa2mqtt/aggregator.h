@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Streaming min/max/mean/count per message and window, one summary is published per window.
+        class Aggregator
+        {
+        public:
+            // topic is relative to the bus topic prefix
+            using SummaryCallback = std::function<void(const std::string &topic, const std::string &payload)>;
+
+            void add_series(MessageNumber messageNumber, uint32_t window);
+            void set_publish_raw(MessageNumber messageNumber, bool publish_raw);
+            bool has_series(const MessageInfo &info)
+            {
+                return !series_of_.empty() && series_of_[catalog_index(info)] != NO_SERIES;
+            }
+
+            // Returns true when the raw value should still be published
+            bool add(const MessageInfo &info, long value, uint32_t now);
+            // Hands out summaries of windows that are complete
+            void flush(uint32_t now, const SummaryCallback &callback);
+
+        private:
+            struct Series
+            {
+                uint32_t window;
+                uint32_t window_start;
+                int64_t sum;
+                int32_t min;
+                int32_t max;
+                uint32_t count;
+                uint16_t index; // catalog index
+                uint16_t next;  // next window of the same message
+            };
+
+            static constexpr uint16_t NO_SERIES = 0xFFFF;
+
+            std::vector<Series> series_;
+            std::vector<uint16_t> series_of_; // first series by catalog index
+            std::vector<bool> publish_raw_;   // by catalog index
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include "analyzer.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // upper bounds (exclusive) of the gap histogram buckets, the last bucket is open
+        static const uint32_t GAP_LIMITS_MS[] = {5, 10, 20, 50, 100, 200, 500, 1000};
+        static const char *const GAP_LABELS[] = {"<5", "<10", "<20", "<50", "<100", "<200", "<500", "<1000", ">=1000"};
+
+        static uint32_t airtime_ms(uint32_t bytes)
+        {
+            return (uint32_t)((uint64_t)bytes * BUS_BITS_PER_BYTE * 1000 / BUS_BITS_PER_SECOND);
+        }
+
+        BusAnalyzer::Slot &BusAnalyzer::slot_for(uint32_t now)
+        {
+            uint32_t index = now / BUS_SLOT_MS;
+            Slot &slot = slots_[index % BUS_SLOTS];
+            if (slot.index != index)
+            {
+                slot = Slot();
+                slot.index = index;
+            }
+            return slot;
+        }
+
+        bool BusAnalyzer::in_window(const Slot &slot, uint32_t now, size_t count)
+        {
+            return now / BUS_SLOT_MS - slot.index < count;
+        }
+
+        size_t BusAnalyzer::source_index(const std::vector<uint8_t> &frame)
+        {
+            // the source address follows start byte and size, whether or not the rest is valid
+            if (frame.size() < 6)
+                return BUS_MAX_SOURCES;
+
+            Address sa;
+            sa.aclass = (AddressClass)frame[3];
+            sa.channel = frame[4];
+            sa.address = frame[5];
+            for (size_t i = 0; i < sources_.size(); i++)
+            {
+                if (sources_[i] == sa)
+                    return i;
+            }
+            if (sources_.size() == BUS_MAX_SOURCES)
+                return BUS_MAX_SOURCES;
+            sources_.push_back(sa);
+            return sources_.size() - 1;
+        }
+
+        void BusAnalyzer::add_frame(const std::vector<uint8_t> &frame, uint32_t start, uint32_t end)
+        {
+            uint32_t wire = airtime_ms(frame.size());
+            if (end - wire < start)
+                start = end - wire;
+
+            Slot &slot = slot_for(end);
+            slot.frames++;
+            slot.bytes += frame.size();
+            slot.source_bytes[source_index(frame)] += frame.size();
+
+            if (has_previous_)
+            {
+                // estimated starts can land before the previous end, that is back to back
+                uint32_t gap = (int32_t)(start - previous_end_) > 0 ? start - previous_end_ : 0;
+                size_t bucket = 0;
+                while (bucket < GAP_BUCKETS - 1 && gap >= GAP_LIMITS_MS[bucket])
+                    bucket++;
+                slot.gaps[bucket]++;
+            }
+            has_previous_ = true;
+            previous_end_ = end;
+        }
+
+        float BusAnalyzer::recent_utilization(uint32_t now)
+        {
+            uint32_t bytes = 0;
+            for (auto &slot : slots_)
+            {
+                if (in_window(slot, now, 2))
+                    bytes += slot.bytes;
+            }
+            uint32_t elapsed = BUS_SLOT_MS + now % BUS_SLOT_MS;
+            return (float)airtime_ms(bytes) / elapsed;
+        }
+
+        std::string BusAnalyzer::stats_to_json(uint32_t now)
+        {
+            uint32_t frames = 0;
+            uint32_t bytes = 0;
+            uint32_t gaps[GAP_BUCKETS] = {};
+            uint32_t source_bytes[BUS_MAX_SOURCES + 1] = {};
+            for (auto &slot : slots_)
+            {
+                if (!in_window(slot, now, BUS_SLOTS))
+                    continue;
+                frames += slot.frames;
+                bytes += slot.bytes;
+                for (size_t i = 0; i < GAP_BUCKETS; i++)
+                    gaps[i] += slot.gaps[i];
+                for (size_t i = 0; i <= BUS_MAX_SOURCES; i++)
+                    source_bytes[i] += slot.source_bytes[i];
+            }
+
+            // the current slot is still filling, and right after boot there is less history
+            uint32_t elapsed = (BUS_SLOTS - 1) * BUS_SLOT_MS + now % BUS_SLOT_MS;
+            if (elapsed > now)
+                elapsed = now;
+            if (elapsed == 0)
+                elapsed = 1;
+
+            char number[16];
+            std::string json = "{\"window_s\":" + std::to_string(elapsed / 1000);
+            json += ",\"frames\":" + std::to_string(frames);
+            snprintf(number, sizeof(number), "%.2f", frames * 1000.0f / elapsed);
+            json += ",\"fps\":" + std::string(number);
+            snprintf(number, sizeof(number), "%.4f", (float)airtime_ms(bytes) / elapsed);
+            json += ",\"utilization\":" + std::string(number);
+
+            json += ",\"gaps_ms\":{";
+            for (size_t i = 0; i < GAP_BUCKETS; i++)
+            {
+                if (i > 0)
+                    json += ",";
+                json += "\"" + std::string(GAP_LABELS[i]) + "\":" + std::to_string(gaps[i]);
+            }
+
+            json += "},\"airtime\":{";
+            bool first = true;
+            for (size_t i = 0; i <= BUS_MAX_SOURCES; i++)
+            {
+                if (source_bytes[i] == 0)
+                    continue;
+                snprintf(number, sizeof(number), "%.4f", (float)source_bytes[i] / bytes);
+                if (!first)
+                    json += ",";
+                first = false;
+                json += "\"" + (i < sources_.size() ? sources_[i].to_string() : std::string("other")) + "\":" + number;
+            }
+            json += "}}";
+            return json;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // 9600 baud 8E1: start, 8 data, parity and stop bit per byte
+        static const uint32_t BUS_BITS_PER_SECOND = 9600;
+        static const uint32_t BUS_BITS_PER_BYTE = 11;
+
+        // Rolling window of BUS_SLOTS slots of BUS_SLOT_MS each
+        static const uint32_t BUS_SLOT_MS = 10000;
+        static const size_t BUS_SLOTS = 6;
+        // Sources beyond this many share one "other" counter
+        static const size_t BUS_MAX_SOURCES = 15;
+
+        // Airtime of the bus from the frames the assembler cut out of it. Frame start and end are
+        // the times the first and last byte were read; since reads lag the wire, the start is also
+        // estimated back from the end and the frame length at 9600 baud, and the earlier one wins.
+        // Everything is kept in fixed size counters per slot, so old slots simply get overwritten.
+        class BusAnalyzer
+        {
+        public:
+            void add_frame(const std::vector<uint8_t> &frame, uint32_t start, uint32_t end);
+
+            // Share of the bus time the last two slots were busy, 0..1, for anything that wants
+            // to stay off a crowded bus
+            float recent_utilization(uint32_t now);
+
+            // Over the whole window: {"window_s":..,"frames":..,"fps":..,"utilization":..,
+            // "gaps_ms":{"<5":..,..,">=1000":..},"airtime":{"<address>":<share>,..}}
+            std::string stats_to_json(uint32_t now);
+
+        private:
+            static const size_t GAP_BUCKETS = 9;
+
+            struct Slot
+            {
+                uint32_t index = 0;
+                uint32_t frames = 0;
+                uint32_t bytes = 0;
+                uint32_t gaps[GAP_BUCKETS] = {};
+                // [BUS_MAX_SOURCES] is "other"
+                uint32_t source_bytes[BUS_MAX_SOURCES + 1] = {};
+            };
+
+            Slot &slot_for(uint32_t now);
+            size_t source_index(const std::vector<uint8_t> &frame);
+            // Slots that belong to the count most recent slot numbers up to now
+            bool in_window(const Slot &slot, uint32_t now, size_t count);
+
+            Slot slots_[BUS_SLOTS];
+            std::vector<Address> sources_;
+            bool has_previous_ = false;
+            uint32_t previous_end_ = 0;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
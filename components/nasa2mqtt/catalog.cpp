@@ -0,0 +1,385 @@
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // All known messages, sorted by message number. __init__.py reads this table to build
+        // NASA2MQTT_MESSAGE_FILTER, so keep one entry per line.
+        static constexpr MessageInfo ALL_MESSAGES[] = {
+            {MessageNumber::VAR_AD_ERROR_CODE1_202, MessageGroup::Address, MessagePriority::Critical},
+            {MessageNumber::VAR_AD_INSTALL_NUMBER_INDOOR_207, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_ADDRESS_RMC_402, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_ALL_409, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_POWER_40A, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_MODE_40B, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_FAN_MODE_40C, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_FAN_DIRECTION_40D, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_TEMP_TARGET_40E, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_MODE_ONLY_410, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_COOL_MODE_UPPER_411, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_COOL_MODE_LOWER_412, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_HEAT_MODE_UPPER_413, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_HEAT_MODE_LOWER_414, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_CONTACT_CONTROL_415, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_INSTALL_LEVEL_KEY_OPERATION_INPUT_416, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_417, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_418, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_419, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::LVAR_AD_41B, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::STR_AD_ID_SERIAL_NUMBER_607, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::STR_AD_ID_MODEL_NAME_61F, MessageGroup::Address, MessagePriority::Normal},
+            {MessageNumber::ENUM_NM_2004, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::ENUM_NM_2012, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22F7, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22F9, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FA, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FB, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FC, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FD, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FE, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::VAR_NM_22FF, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::LVAR_NM_2400, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::LVAR_NM_2401, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::LVAR_NM_24FB, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::LVAR_NM_24FC, MessageGroup::Network, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_OPERATION_POWER_4000, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_OPERATION_MODE_4001, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_OPERATION_MODE_REAL_4002, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FAN_MODE_4006, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FAN_MODE_REAL_4007, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_400F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4010, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4015, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4019, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_401B, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4023, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4024, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4027, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_STATE_THERMO_4028, MessageGroup::Indoor, MessagePriority::Critical},
+            {MessageNumber::ENUM_IN_4029, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_402A, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_402B, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_402D, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_STATE_DEFROST_MODE_402E, MessageGroup::Indoor, MessagePriority::Critical},
+            {MessageNumber::ENUM_IN_4031, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4035, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_STATE_HUMIDITY_PERCENT_4038, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4043, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_SILENCE_4046, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4047, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4048, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_404F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4051, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4059, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_405F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_ALTERNATIVE_MODE_4060, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_WATER_HEATER_POWER_4065, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_WATER_HEATER_MODE_4066, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_3WAY_VALVE_4067, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_SOLAR_PUMP_4068, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_THERMOSTAT1_4069, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_THERMOSTAT2_406A, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_406B, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_BACKUP_HEATER_406C, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_OUTING_MODE_406D, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_REFERENCE_EHS_TEMP_406F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_DISCHAGE_TEMP_CONTROL_4070, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4073, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4074, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4077, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_407B, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_407D, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_LOUVER_LR_SWING_407E, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4085, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4086, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_BOOSTER_HEATER_4087, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_STATE_WATER_PUMP_4089, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_2WAY_VALVE_408A, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_2091_4095, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_2092_4096, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_3011_4097, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_3041_4099, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_3042_409A, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_3061_409C, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_5061_40B4, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_40B5, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_WATERPUMP_PWM_VALUE_40C4, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_THERMOSTAT_WATER_HEATER_40C5, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_40C6, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_4117, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_4061_411A, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_OPERATION_POWER_ZONE2_411E, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_SG_READY_MODE_STATE_4124, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_LOAD_SAVE_4125, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_2093_4127, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::ENUM_IN_FSV_5022_4128, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_TARGET_F_4201, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_4202, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_ROOM_F_4203, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_4204, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_EVA_IN_F_4205, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_EVA_OUT_F_4206, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_420C, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_CAPACITY_REQUEST_4211, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_CAPACITY_ABSOLUTE_4212, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_4213, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_EEV_VALUE_REAL_1_4217, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_MODEL_INFORMATION_4229, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_HEATER_TARGET_F_4235, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_TANK_F_4237, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUT_F_4238, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUT2_F_4239, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_423E, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_F_4247, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_LAW_TARGET_F_4248, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1011_424A, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1012_424B, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1021_424C, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1022_424D, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1031_424E, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1032_424F, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1041_4250, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1042_4251, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1051_4252, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_1052_4253, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_3043_4269, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_3044_426A, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_3045_426B, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5011_4273, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5012_4274, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5013_4275, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5014_4276, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5015_4277, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5016_4278, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5017_4279, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5018_427A, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_5019_427B, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_LAW_F_427F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_MIXING_VALVE_F_428C, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_428D, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FSV_3046_42CE, MessageGroup::Fsv, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_ZONE2_F_42D4, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_TARGET_ZONE2_F_42D6, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_ZONE2_F_42D7, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE1_F_42D8, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE2_F_42D9, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FLOW_SENSOR_VOLTAGE_42E8, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_FLOW_SENSOR_CALC_42E9, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_42F1, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::VAR_IN_4301, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_4401, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_DEVICE_STAUS_HEATPUMP_BOILER_440A, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_440E, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_440F, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_4423, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_4424, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_4426, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_IN_4427, MessageGroup::Indoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_OPERATION_SERVICE_OP_8000, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_OPERATION_ODU_MODE_8001, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8002, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_OPERATION_HEATCOOL_8003, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8005, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_800D, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_LOAD_COMP1_8010, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_LOAD_HOTGAS_8017, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_LOAD_4WAY_801A, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_LOAD_OUTEEV_8020, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8031, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8032, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8033, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_803F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8043, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8045, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_OP_TEST_OP_COMPLETE_8046, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8047, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8048, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_805E, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_DEICE_STEP_INDOOR_8061, MessageGroup::Outdoor, MessagePriority::Critical},
+            {MessageNumber::ENUM_OUT_8066, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8077, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8079, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_807C, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_807D, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_807E, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_8081, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_808C, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_808D, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_OP_CHECK_REF_STEP_808E, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_808F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80A8, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80A9, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80AA, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80AB, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80AE, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_LOAD_BASEHEATER_80AF, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80B1, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::ENUM_OUT_80CE, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8200, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8201, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_INSTALL_COMP_NUM_8202, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_AIROUT_8204, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_HIGHPRESS_8206, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_LOWPRESS_8208, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_DISCHARGE1_820A, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_CT1_8217, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_CONDOUT_8218, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_SUCTION_821A, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_TARGET_DISCHARGE_8223, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8225, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_LOAD_OUTEEV1_8229, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_LOAD_OUTEEV4_822C, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8233, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_ERROR_CODE_8235, MessageGroup::Outdoor, MessagePriority::Critical},
+            {MessageNumber::VAR_OUT_CONTROL_ORDER_CFREQ_COMP1_8236, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_TARGET_CFREQ_COMP1_8237, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_CFREQ_COMP1_8238, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8239, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_DCLINK_VOLTAGE_823B, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_LOAD_FANRPM1_823D, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_LOAD_FANRPM2_823E, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_823F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8243, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8247, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8248, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_824B, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_824C, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_REFRIGERANTS_VOLUME_824F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_IPM1_8254, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_ORDER_CFREQ_COMP2_8274, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_CONTROL_TARGET_CFREQ_COMP2_8275, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_TOP1_8280, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_INSTALL_CAPA_8287, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_HIGH_PRESSURE_829F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_LOW_PRESSURE_82A0, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82A2, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82B5, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82B6, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_PROJECT_CODE_82BC, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82D4, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82D9, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82DA, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_PHASE_CURRENT_82DB, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82DC, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82DD, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_EVAIN_82DE, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_TW1_82DF, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_SENSOR_TW2_82E0, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82E1, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_PRODUCT_OPTION_CAPA_82E3, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_82ED, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_LOAD_COMP1_RUNNING_TIME_8405, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8406, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8408, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_840F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8410, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8411, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8414, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_8417, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::LVAR_OUT_841F, MessageGroup::Outdoor, MessagePriority::Normal},
+            {MessageNumber::VAR_OUT_8249, MessageGroup::Outdoor, MessagePriority::Normal},
+        };
+
+        static constexpr size_t ALL_MESSAGES_SIZE = sizeof(ALL_MESSAGES) / sizeof(ALL_MESSAGES[0]);
+
+        static constexpr bool catalog_sorted()
+        {
+            for (size_t i = 1; i < ALL_MESSAGES_SIZE; i++)
+            {
+                if ((uint16_t)ALL_MESSAGES[i - 1].messageNumber >= (uint16_t)ALL_MESSAGES[i].messageNumber)
+                    return false;
+            }
+            return true;
+        }
+        static_assert(catalog_sorted(), "ALL_MESSAGES must be sorted by message number");
+        static_assert(ALL_MESSAGES_SIZE <= MAX_CATALOG_SIZE, "ALL_MESSAGES outgrew MAX_CATALOG_SIZE");
+
+        static constexpr size_t count_selected()
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < ALL_MESSAGES_SIZE; i++)
+            {
+                if (message_selected(ALL_MESSAGES[i].messageNumber))
+                    count++;
+            }
+            return count;
+        }
+
+        static constexpr size_t CATALOG_SIZE = count_selected();
+
+#ifdef NASA2MQTT_MESSAGE_FILTER
+        static constexpr size_t count_filter_bits()
+        {
+            size_t count = 0;
+            for (uint32_t word : MESSAGE_FILTER)
+            {
+                for (; word != 0; word &= word - 1)
+                    count++;
+            }
+            return count;
+        }
+        static_assert(count_filter_bits() == CATALOG_SIZE, "NASA2MQTT_MESSAGE_FILTER selects messages that are not in the catalog");
+#endif
+
+        struct Catalog
+        {
+            MessageInfo entries[CATALOG_SIZE > 0 ? CATALOG_SIZE : 1];
+        };
+
+        // Only the selected messages end up in flash, ALL_MESSAGES is used at compile time only
+        static constexpr Catalog build_catalog()
+        {
+            Catalog catalog = {};
+            size_t count = 0;
+            for (size_t i = 0; i < ALL_MESSAGES_SIZE; i++)
+            {
+                if (message_selected(ALL_MESSAGES[i].messageNumber))
+                    catalog.entries[count++] = ALL_MESSAGES[i];
+            }
+            return catalog;
+        }
+
+        static constexpr Catalog CATALOG_TABLE = build_catalog();
+        static constexpr const MessageInfo *CATALOG = CATALOG_TABLE.entries;
+
+        size_t catalog_size()
+        {
+            return CATALOG_SIZE;
+        }
+
+        const MessageInfo &catalog_entry(size_t index)
+        {
+            return CATALOG[index];
+        }
+
+        size_t catalog_index(const MessageInfo &info)
+        {
+            return &info - CATALOG;
+        }
+
+        const MessageInfo *find_message_info(MessageNumber messageNumber)
+        {
+            // deselected messages end here: a look at the few pages and one bit test, no search
+            if (!message_selected(messageNumber))
+                return nullptr;
+
+            size_t low = 0;
+            size_t high = CATALOG_SIZE;
+            while (low < high)
+            {
+                size_t mid = (low + high) / 2;
+                if ((uint16_t)CATALOG[mid].messageNumber < (uint16_t)messageNumber)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            if (low < CATALOG_SIZE && CATALOG[low].messageNumber == messageNumber)
+                return &CATALOG[low];
+            return nullptr;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
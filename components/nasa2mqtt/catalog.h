@@ -0,0 +1,70 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        enum class MessagePriority : uint8_t
+        {
+            Normal = 0,
+            // error codes and state changes: never held back, published with QoS 1 and retain
+            Critical = 1
+        };
+
+        enum class MessageGroup : uint8_t
+        {
+            Address = 0,
+            Network = 1,
+            Indoor = 2,
+            Outdoor = 3,
+            // field setting values, whatever unit they come from
+            Fsv = 4
+        };
+
+        struct MessageInfo
+        {
+            MessageNumber messageNumber;
+            MessageGroup group;
+            MessagePriority priority;
+        };
+
+#ifdef NASA2MQTT_MESSAGE_FILTER
+        // Generated from the include/exclude lists in the yaml: the high bytes of the selected
+        // message numbers, and for each of them one bit per low byte
+        static constexpr uint8_t MESSAGE_PAGES[] = {NASA2MQTT_MESSAGE_PAGES};
+        static constexpr uint32_t MESSAGE_FILTER[] = {NASA2MQTT_MESSAGE_FILTER};
+        static_assert(sizeof(MESSAGE_FILTER) == sizeof(MESSAGE_PAGES) * 32, "NASA2MQTT_MESSAGE_FILTER needs 256 bits per page");
+#endif
+
+        // Whether a message was selected at compile time, always true without a selection. Also
+        // used to leave the metadata of deselected messages out of constexpr tables.
+        static constexpr bool message_selected(MessageNumber messageNumber)
+        {
+#ifdef NASA2MQTT_MESSAGE_FILTER
+            const uint16_t number = (uint16_t)messageNumber;
+            for (size_t page = 0; page < sizeof(MESSAGE_PAGES); page++)
+            {
+                if (MESSAGE_PAGES[page] == number >> 8)
+                    return (MESSAGE_FILTER[page * 8 + (number & 0xFF) / 32] >> (number % 32)) & 1;
+            }
+            return false;
+#else
+            return true;
+#endif
+        }
+
+        // Entries fixed size per-message bitmaps have room for, like the publish filter kept in flash
+        static const size_t MAX_CATALOG_SIZE = 512;
+
+        size_t catalog_size();
+        const MessageInfo &catalog_entry(size_t index);
+        // Position of a catalog entry, for flat per-message state arrays
+        size_t catalog_index(const MessageInfo &info);
+        // nullptr for messages that are not published
+        const MessageInfo *find_message_info(MessageNumber messageNumber);
+
+    } // namespace nasa2mqtt
+} // namespace esphome
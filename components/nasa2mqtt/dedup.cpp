@@ -0,0 +1,89 @@
+#include <cstdio>
+#include "dedup.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // FNV-1a, continuing from hash
+        static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t length)
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                hash ^= data[i];
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        static const uint32_t FNV_OFFSET = 2166136261u;
+
+        void FrameDedup::setup(uint32_t max_age)
+        {
+            max_age_ = max_age;
+            kinds_.reserve(MAX_KINDS);
+        }
+
+        bool FrameDedup::repeated(const std::vector<uint8_t> &data, const Packet &packet, uint32_t now)
+        {
+            // addresses, command up to the packet number, message count and first message number;
+            // decode_header made sure the frame reaches that far
+            const size_t number = 3 + packet.sa.size + packet.da.size + packet.pcommand.size - 1;
+            const size_t messages = number + 1;
+            uint32_t signature = fnv1a(FNV_OFFSET, data.data() + 3, number - 3);
+            signature = fnv1a(signature, data.data() + messages, 3);
+            // the message sets, crc and end byte left out
+            const uint32_t hash = fnv1a(FNV_OFFSET, data.data() + messages, data.size() - 3 - messages);
+
+            lookups++;
+            Kind *oldest = nullptr;
+            for (auto &kind : kinds_)
+            {
+                if (kind.signature == signature)
+                {
+                    kind.seen = now;
+                    last_ = &kind - kinds_.data();
+                    if (kind.hash == hash && !kind.always && now - kind.processed < max_age_)
+                    {
+                        hits++;
+                        return true;
+                    }
+                    kind.hash = hash;
+                    kind.processed = now;
+                    return false;
+                }
+                if (oldest == nullptr || now - kind.seen > now - oldest->seen)
+                    oldest = &kind;
+            }
+
+            if (kinds_.size() < MAX_KINDS)
+            {
+                last_ = kinds_.size();
+                kinds_.push_back({signature, hash, now, now, false});
+            }
+            else
+            {
+                last_ = oldest - kinds_.data();
+                *oldest = {signature, hash, now, now, false};
+            }
+            return false;
+        }
+
+        void FrameDedup::decode_always()
+        {
+            if (last_ < kinds_.size())
+                kinds_[last_].always = true;
+        }
+
+        std::string FrameDedup::stats_to_json()
+        {
+            char rate[16];
+            snprintf(rate, sizeof(rate), "%.4f", lookups == 0 ? 0.0 : (double)hits / lookups);
+            return "{\"kinds\":" + std::to_string(kinds_.size()) +
+                   ",\"lookups\":" + std::to_string(lookups) +
+                   ",\"hits\":" + std::to_string(hits) +
+                   ",\"hit_rate\":" + std::string(rate) + "}";
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Units send the same notifications over and over with only the packet number changed.
+        // Keeps the last frame of each kind (source, destination, command, message count and first
+        // message) as a hash of its bytes without packet number and crc; a notification equal to the
+        // last one of its kind carries nothing new and is not decoded at all. Once max_age has passed
+        // since a kind was last processed, the next repeat goes through anyway, so values still
+        // reach MQTT now and then when nothing changes. Kinds marked with decode_always() are never
+        // skipped: their messages feed aggregation windows, history or the energy integrals, which
+        // need every sample.
+        class FrameDedup
+        {
+        public:
+            // nothing is skipped without a max_age
+            void setup(uint32_t max_age);
+            bool enabled()
+            {
+                return max_age_ > 0;
+            }
+
+            // packet has its header decoded from data. True when data repeats the last frame of
+            // its kind; either way the kind counts as seen now.
+            bool repeated(const std::vector<uint8_t> &data, const Packet &packet, uint32_t now);
+            // Repeats of the kind of the frame last passed to repeated() are decoded from now on
+            void decode_always();
+
+            // {"kinds":..,"lookups":..,"hits":..,"hit_rate":<hits/lookups>}
+            std::string stats_to_json();
+
+            uint32_t lookups = 0;
+            uint32_t hits = 0;
+
+        private:
+            struct Kind
+            {
+                uint32_t signature;
+                uint32_t hash;
+                uint32_t processed; // last time a frame of this kind was let through
+                uint32_t seen;
+                bool always;
+            };
+
+            static const size_t MAX_KINDS = 64;
+
+            uint32_t max_age_ = 0;
+            std::vector<Kind> kinds_;
+            size_t last_ = 0; // kind of the frame last looked up
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
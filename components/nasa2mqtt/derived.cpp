@@ -0,0 +1,149 @@
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include "derived.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        struct DerivedInput
+        {
+            MessageNumber messageNumber;
+            uint8_t affects; // DerivedMetric mask
+        };
+
+        // Which metrics have to be recomputed when an input changes
+        static constexpr DerivedInput DERIVED_INPUTS[] = {
+            {MessageNumber::VAR_IN_FLOW_SENSOR_CALC_42E9, HEAT_OUTPUT | COP | ENERGY_PRODUCED},
+            {MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236, HEAT_OUTPUT | COP | ENERGY_PRODUCED},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUT_F_4238, HEAT_OUTPUT | COP | ENERGY_PRODUCED},
+            {MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413, COP | ENERGY_CONSUMED},
+        };
+        enum DerivedInputIndex
+        {
+            FLOW = 0,
+            WATER_IN = 1,
+            WATER_OUT = 2,
+            POWER = 3
+        };
+        static constexpr uint8_t WATER_INPUTS = (1 << FLOW) | (1 << WATER_IN) | (1 << WATER_OUT);
+        static constexpr uint8_t ALL_INPUTS = WATER_INPUTS | (1 << POWER);
+
+        static const char *const DERIVED_TOPICS[] = {
+            "derived/heat_output",
+            "derived/cop",
+            "derived/energy_consumed",
+            "derived/energy_produced",
+        };
+
+        // Gaps longer than this (bus or gateway down) are not integrated
+        static const uint32_t MAX_INTEGRATION_GAP_MS = 5 * 60 * 1000;
+        // Only write to flash after this much energy (Wh) was added
+        static const double SAVE_THRESHOLD_WH = 10;
+
+        void DerivedMetrics::setup(const std::string &key)
+        {
+            if (!enabled_)
+                return;
+
+            pref_ = global_preferences->make_preference<EnergyCounters>(fnv1_hash("nasa2mqtt_energy_" + key));
+            if (pref_.load(&energy_))
+                ESP_LOGI(TAG, "Restored energy counters: consumed %.3f kWh, produced %.3f kWh", energy_.consumed / 1000, energy_.produced / 1000);
+            else
+                energy_ = {};
+            saved_ = energy_;
+        }
+
+        void DerivedMetrics::save()
+        {
+            if (!enabled_)
+                return;
+
+            if (energy_.consumed - saved_.consumed < SAVE_THRESHOLD_WH && energy_.produced - saved_.produced < SAVE_THRESHOLD_WH)
+                return;
+
+            if (pref_.save(&energy_))
+                saved_ = energy_;
+        }
+
+        void DerivedMetrics::integrate(double &energy, double power, uint32_t &since, uint32_t now)
+        {
+            if (since != 0 && now - since <= MAX_INTEGRATION_GAP_MS)
+                energy += power * (now - since) / 3600000.0;
+            since = now;
+        }
+
+        bool DerivedMetrics::is_input(MessageNumber messageNumber)
+        {
+            if (!enabled_)
+                return false;
+            for (auto &input : DERIVED_INPUTS)
+            {
+                if (input.messageNumber == messageNumber)
+                    return true;
+            }
+            return false;
+        }
+
+        void DerivedMetrics::update(MessageNumber messageNumber, long value, uint32_t now, const PublishCallback &callback)
+        {
+            if (!enabled_)
+                return;
+
+            uint8_t affected = 0;
+            for (size_t i = 0; i < sizeof(DERIVED_INPUTS) / sizeof(DERIVED_INPUTS[0]); i++)
+            {
+                if (DERIVED_INPUTS[i].messageNumber == messageNumber)
+                {
+                    inputs_[i] = value;
+                    known_ |= 1 << i;
+                    affected = DERIVED_INPUTS[i].affects;
+                    break;
+                }
+            }
+            if (affected == 0)
+                return;
+
+            // the energy integrals use the previous power until now, then continue with the new one
+            if (affected & ENERGY_CONSUMED)
+            {
+                integrate(energy_.consumed, power_, power_since_, now);
+                power_ = inputs_[POWER];
+            }
+            if ((affected & HEAT_OUTPUT) && (known_ & WATER_INPUTS) == WATER_INPUTS)
+            {
+                integrate(energy_.produced, heat_output_, heat_since_, now);
+                // flow in 0.1 l/min, temperatures in 0.1 °C, water carries 4186 J/(l*K)
+                double flow = inputs_[FLOW] / 10.0 / 60.0;
+                double delta = (inputs_[WATER_OUT] - inputs_[WATER_IN]) / 10.0;
+                heat_output_ = flow * delta * 4186.0;
+                if (heat_output_ < 0)
+                    heat_output_ = 0; // defrost pulls heat out of the water, that is not output
+            }
+
+            char payloads[4][16];
+            sprintf(payloads[0], "%.0f", heat_output_);
+            sprintf(payloads[1], "%.2f", power_ > 0 ? heat_output_ / power_ : 0.0);
+            sprintf(payloads[2], "%.3f", energy_.consumed / 1000);
+            sprintf(payloads[3], "%.3f", energy_.produced / 1000);
+
+            for (uint8_t i = 0; i < 4; i++)
+            {
+                if (!(affected & (1 << i)))
+                    continue;
+                if ((1 << i) & (HEAT_OUTPUT | ENERGY_PRODUCED) && (known_ & WATER_INPUTS) != WATER_INPUTS)
+                    continue;
+                if ((1 << i) == COP && known_ != ALL_INPUTS)
+                    continue;
+                if (published_[i] == payloads[i])
+                    continue;
+
+                published_[i] = payloads[i];
+                callback(DERIVED_TOPICS[i], payloads[i]);
+            }
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <functional>
+#include "esphome/core/preferences.h"
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Metrics computed on the device from several messages, updated whenever one of their inputs changes
+        enum DerivedMetric : uint8_t
+        {
+            HEAT_OUTPUT = 1 << 0,     // W, from flow and water in/out temperature
+            COP = 1 << 1,             // heat output / electrical power
+            ENERGY_CONSUMED = 1 << 2, // kWh, integrated electrical power
+            ENERGY_PRODUCED = 1 << 3, // kWh, integrated heat output
+        };
+
+        class DerivedMetrics
+        {
+        public:
+            // topic is relative to the bus topic prefix
+            using PublishCallback = std::function<void(const std::string &topic, const std::string &payload)>;
+
+            void set_enabled(bool enabled)
+            {
+                enabled_ = enabled;
+            }
+
+            // Restores the energy counters from flash, key tells the buses apart
+            void setup(const std::string &key);
+            void update(MessageNumber messageNumber, long value, uint32_t now, const PublishCallback &callback);
+            // True for the messages the metrics are computed from, while enabled
+            bool is_input(MessageNumber messageNumber);
+            // Writes the energy counters to flash when they moved enough to be worth it
+            void save();
+
+        private:
+            struct EnergyCounters
+            {
+                double consumed; // Wh
+                double produced; // Wh
+            };
+
+            void integrate(double &energy, double power, uint32_t &since, uint32_t now);
+
+            bool enabled_ = false;
+            long inputs_[4] = {};
+            uint8_t known_ = 0;
+
+            double heat_output_ = 0;
+            double power_ = 0;
+            uint32_t heat_since_ = 0;
+            uint32_t power_since_ = 0;
+            std::string published_[4];
+
+            EnergyCounters energy_ = {};
+            EnergyCounters saved_ = {};
+            ESPPreferenceObject pref_;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,245 @@
+#include "esphome/core/log.h"
+#include "discovery.h"
+#include "util.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        using C = DiscoveryComponent;
+
+        // Sorted by message number
+        static constexpr DiscoveryInfo ALL_DISCOVERY[] = {
+            {MessageNumber::VAR_AD_ERROR_CODE1_202, C::Sensor, "Error code", nullptr, nullptr, nullptr, 1, false},
+            {MessageNumber::ENUM_IN_OPERATION_POWER_4000, C::BinarySensor, "Power", nullptr, "power", nullptr, 1, false},
+            {MessageNumber::ENUM_IN_STATE_THERMO_4028, C::BinarySensor, "Thermostat demand", nullptr, "heat", nullptr, 1, false},
+            {MessageNumber::ENUM_IN_STATE_DEFROST_MODE_402E, C::BinarySensor, "Defrost", nullptr, "running", nullptr, 1, false},
+            {MessageNumber::ENUM_IN_STATE_HUMIDITY_PERCENT_4038, C::Sensor, "Humidity", "%", "humidity", "measurement", 1, false},
+            {MessageNumber::ENUM_IN_WATER_HEATER_POWER_4065, C::BinarySensor, "Hot water", nullptr, "power", nullptr, 1, false},
+            {MessageNumber::ENUM_IN_BOOSTER_HEATER_4087, C::BinarySensor, "Booster heater", nullptr, "running", nullptr, 1, false},
+            {MessageNumber::ENUM_IN_STATE_WATER_PUMP_4089, C::BinarySensor, "Water pump", nullptr, "running", nullptr, 1, false},
+            {MessageNumber::VAR_IN_TEMP_TARGET_F_4201, C::Sensor, "Target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_ROOM_F_4203, C::Sensor, "Room temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_EVA_IN_F_4205, C::Sensor, "Evaporator in temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_EVA_OUT_F_4206, C::Sensor, "Evaporator out temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_HEATER_TARGET_F_4235, C::Sensor, "Hot water target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236, C::Sensor, "Water in temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_TANK_F_4237, C::Sensor, "Hot water tank temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUT_F_4238, C::Sensor, "Water out temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUT2_F_4239, C::Sensor, "Water out 2 temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_F_4247, C::Sensor, "Water outlet target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_LAW_TARGET_F_4248, C::Sensor, "Water law target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_LAW_F_427F, C::Sensor, "Water law temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_MIXING_VALVE_F_428C, C::Sensor, "Mixing valve temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_ZONE2_F_42D4, C::Sensor, "Zone 2 temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_TARGET_ZONE2_F_42D6, C::Sensor, "Zone 2 target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_ZONE2_F_42D7, C::Sensor, "Zone 2 water outlet target temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE1_F_42D8, C::Sensor, "Zone 1 water outlet temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE2_F_42D9, C::Sensor, "Zone 2 water outlet temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_IN_FLOW_SENSOR_CALC_42E9, C::Sensor, "Water flow", "L/min", "volume_flow_rate", "measurement", 10, false},
+            {MessageNumber::LVAR_IN_4427, C::Sensor, "Heat produced", "Wh", "energy", "total_increasing", 1, false},
+            {MessageNumber::VAR_OUT_SENSOR_AIROUT_8204, C::Sensor, "Outdoor temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_DISCHARGE1_820A, C::Sensor, "Discharge temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_CT1_8217, C::Sensor, "Compressor current", "A", "current", "measurement", 10, false},
+            {MessageNumber::VAR_OUT_SENSOR_CONDOUT_8218, C::Sensor, "Condenser out temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_SUCTION_821A, C::Sensor, "Suction temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_ERROR_CODE_8235, C::Sensor, "Outdoor error code", nullptr, nullptr, nullptr, 1, false},
+            {MessageNumber::VAR_OUT_CONTROL_CFREQ_COMP1_8238, C::Sensor, "Compressor frequency", "Hz", "frequency", "measurement", 1, false},
+            {MessageNumber::VAR_OUT_SENSOR_DCLINK_VOLTAGE_823B, C::Sensor, "DC link voltage", "V", "voltage", "measurement", 1, false},
+            {MessageNumber::VAR_OUT_LOAD_FANRPM1_823D, C::Sensor, "Fan speed", "rpm", nullptr, "measurement", 1, false},
+            {MessageNumber::VAR_OUT_SENSOR_TOP1_8280, C::Sensor, "Compressor top temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_HIGH_PRESSURE_829F, C::Sensor, "High pressure saturation temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_LOW_PRESSURE_82A0, C::Sensor, "Low pressure saturation temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_EVAIN_82DE, C::Sensor, "Outdoor evaporator in temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_TW1_82DF, C::Sensor, "TW1 temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::VAR_OUT_SENSOR_TW2_82E0, C::Sensor, "TW2 temperature", "°C", "temperature", "measurement", 10, true},
+            {MessageNumber::LVAR_OUT_LOAD_COMP1_RUNNING_TIME_8405, C::Sensor, "Compressor running time", "h", "duration", "total_increasing", 1, false},
+            {MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413, C::Sensor, "Power consumption", "W", "power", "measurement", 1, false},
+            {MessageNumber::LVAR_OUT_8414, C::Sensor, "Energy consumed", "Wh", "energy", "total_increasing", 1, false},
+        };
+
+        static constexpr size_t ALL_DISCOVERY_SIZE = sizeof(ALL_DISCOVERY) / sizeof(ALL_DISCOVERY[0]);
+
+        static constexpr bool discovery_sorted()
+        {
+            for (size_t i = 1; i < ALL_DISCOVERY_SIZE; i++)
+            {
+                if ((uint16_t)ALL_DISCOVERY[i - 1].messageNumber >= (uint16_t)ALL_DISCOVERY[i].messageNumber)
+                    return false;
+            }
+            return true;
+        }
+        static_assert(discovery_sorted(), "ALL_DISCOVERY must be sorted by message number");
+
+        static constexpr size_t count_selected()
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < ALL_DISCOVERY_SIZE; i++)
+            {
+                if (message_selected(ALL_DISCOVERY[i].messageNumber))
+                    count++;
+            }
+            return count;
+        }
+
+        static constexpr size_t DISCOVERY_SIZE = count_selected();
+
+        struct DiscoveryTable
+        {
+            DiscoveryInfo entries[DISCOVERY_SIZE > 0 ? DISCOVERY_SIZE : 1];
+        };
+
+        // Like the catalog, only the metadata of selected messages ends up in flash
+        static constexpr DiscoveryTable build_discovery()
+        {
+            DiscoveryTable table = {};
+            size_t count = 0;
+            for (size_t i = 0; i < ALL_DISCOVERY_SIZE; i++)
+            {
+                if (message_selected(ALL_DISCOVERY[i].messageNumber))
+                    table.entries[count++] = ALL_DISCOVERY[i];
+            }
+            return table;
+        }
+
+        static constexpr DiscoveryTable DISCOVERY_TABLE = build_discovery();
+        static constexpr const DiscoveryInfo *DISCOVERY = DISCOVERY_TABLE.entries;
+
+        const DiscoveryInfo *find_discovery_info(MessageNumber messageNumber)
+        {
+            size_t low = 0;
+            size_t high = DISCOVERY_SIZE;
+            while (low < high)
+            {
+                size_t mid = (low + high) / 2;
+                if ((uint16_t)DISCOVERY[mid].messageNumber < (uint16_t)messageNumber)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            if (low < DISCOVERY_SIZE && DISCOVERY[low].messageNumber == messageNumber)
+                return &DISCOVERY[low];
+            return nullptr;
+        }
+
+        static const uint8_t MAX_DEVICES = 16;
+
+        static std::string device_name(const Address &address)
+        {
+            switch (address.aclass)
+            {
+            case AddressClass::Outdoor:
+                return "Outdoor unit";
+            case AddressClass::Indoor:
+                return "Indoor unit";
+            default:
+                return "Device";
+            }
+        }
+
+        // topic levels and ids allow letters, digits, _ and -
+        static std::string node_id(const std::string &topic_prefix)
+        {
+            std::string node = topic_prefix;
+            for (auto &c : node)
+            {
+                if (!isalnum((unsigned char)c) && c != '_' && c != '-')
+                    c = '_';
+            }
+            return node;
+        }
+
+        void Discovery::setup(const std::string &prefix, uint32_t interval, uint8_t burst)
+        {
+            prefix_ = prefix;
+            interval_ = interval;
+            burst_ = burst;
+            tokens_ = burst;
+            queued_.assign((catalog_size() + 31) / 32, 0);
+            pending_.reserve(catalog_size());
+        }
+
+        void Discovery::seen(const MessageInfo &info, const Address &source)
+        {
+            const size_t index = catalog_index(info);
+            if ((queued_[index / 32] >> (index % 32)) & 1)
+                return;
+            if (find_discovery_info(info.messageNumber) == nullptr)
+                return;
+
+            size_t device = 0;
+            while (device < devices_.size() && !(devices_[device] == source))
+                device++;
+            if (device == devices_.size())
+            {
+                if (devices_.size() == MAX_DEVICES)
+                    return;
+                devices_.push_back(source);
+                ESP_LOGD(TAG, "Discovery: new device %s", devices_.back().to_string().c_str());
+            }
+            pending_.push_back({(uint16_t)index, (uint8_t)device});
+            // only now: a message first sent by a device over the cap is still announced once a known
+            // device sends it
+            queued_[index / 32] |= 1u << (index % 32);
+        }
+
+        void Discovery::loop(uint32_t now, const std::string &topic_prefix,
+                             const std::function<const std::string &(MessageNumber)> &state_topic, const PublishCallback &callback)
+        {
+            uint32_t refills = (now - last_refill_) / interval_;
+            if (refills > 0)
+            {
+                tokens_ = refills >= burst_ || tokens_ + refills >= burst_ ? burst_ : tokens_ + refills;
+                last_refill_ += refills * interval_;
+            }
+
+            size_t sent = 0;
+            const std::string node = pending_.empty() ? std::string() : node_id(topic_prefix);
+            while (sent < pending_.size() && tokens_ > 0)
+            {
+                const Pending &pending = pending_[sent];
+                const MessageInfo &info = catalog_entry(pending.index);
+                const DiscoveryInfo &meta = *find_discovery_info(info.messageNumber);
+                const std::string hex = long_to_hex((uint16_t)info.messageNumber);
+                const std::string topic = prefix_ + (meta.component == DiscoveryComponent::BinarySensor ? "/binary_sensor/" : "/sensor/") +
+                                          node + "/" + hex + "/config";
+                if (!callback(topic, config_payload(meta, devices_[pending.device], node, state_topic(info.messageNumber))))
+                    break;
+                tokens_--;
+                sent++;
+                announced++;
+            }
+            pending_.erase(pending_.begin(), pending_.begin() + sent);
+        }
+
+        std::string Discovery::config_payload(const DiscoveryInfo &meta, const Address &device, const std::string &node,
+                                              const std::string &state_topic)
+        {
+            Address address = device;
+            const std::string hex = long_to_hex((uint16_t)meta.messageNumber);
+            const std::string device_id = node + "_" + long_to_hex((long)address.aclass << 16 | address.channel << 8 | address.address);
+
+            std::string json = "{\"name\":\"" + std::string(meta.name) + "\"";
+            json += ",\"unique_id\":\"" + node + "_" + hex + "\"";
+            json += ",\"state_topic\":\"" + state_topic + "\"";
+            if (meta.component == DiscoveryComponent::BinarySensor)
+                json += ",\"payload_on\":\"1\",\"payload_off\":\"0\"";
+            if (meta.unit != nullptr)
+                json += ",\"unit_of_measurement\":\"" + std::string(meta.unit) + "\"";
+            if (meta.device_class != nullptr)
+                json += ",\"device_class\":\"" + std::string(meta.device_class) + "\"";
+            if (meta.state_class != nullptr)
+                json += ",\"state_class\":\"" + std::string(meta.state_class) + "\"";
+            if (meta.is_signed)
+                json += ",\"value_template\":\"{% set v = value | int %}{{ (v - 65536 if v > 32767 else v) / " + std::to_string(meta.divisor) + " }}\"";
+            else if (meta.divisor != 1)
+                json += ",\"value_template\":\"{{ (value | int) / " + std::to_string(meta.divisor) + " }}\"";
+            json += ",\"device\":{\"identifiers\":[\"" + device_id + "\"],\"name\":\"" + device_name(address) + " " +
+                    address.to_string() + "\",\"manufacturer\":\"Samsung\"}}";
+            return json;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
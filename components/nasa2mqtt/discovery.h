@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        enum class DiscoveryComponent : uint8_t
+        {
+            Sensor = 0,
+            // state topic carries 0 or 1
+            BinarySensor = 1
+        };
+
+        // What Home Assistant needs to know about a message beyond its state topic.
+        // Strings are Home Assistant's own names, nullptr when not applicable.
+        struct DiscoveryInfo
+        {
+            MessageNumber messageNumber;
+            DiscoveryComponent component;
+            const char *name;
+            const char *unit;
+            const char *device_class;
+            const char *state_class;
+            uint8_t divisor;  // raw value / divisor is the value in unit
+            bool is_signed;   // raw value is a signed 16 bit number
+        };
+
+        // nullptr for messages without discovery metadata, which are not announced
+        const DiscoveryInfo *find_discovery_info(MessageNumber messageNumber);
+
+        // Home Assistant MQTT discovery. A message is announced the first time a value of it arrives,
+        // as an entity of the device that sent it. Configs are retained and queued, then sent by a
+        // token bucket so a freshly booted gateway does not send all of them at once.
+        class Discovery
+        {
+        public:
+            // topic and payload of a retained config, false when it could not be sent and should be retried
+            using PublishCallback = std::function<bool(const std::string &topic, const std::string &payload)>;
+
+            // prefix Home Assistant listens on, usually "homeassistant"; nothing is announced without
+            void setup(const std::string &prefix, uint32_t interval, uint8_t burst);
+            bool enabled()
+            {
+                return !prefix_.empty();
+            }
+
+            void seen(const MessageInfo &info, const Address &source);
+            // Sends queued configs while tokens last. topic_prefix and state_topic are the publisher's.
+            void loop(uint32_t now, const std::string &topic_prefix,
+                      const std::function<const std::string &(MessageNumber)> &state_topic, const PublishCallback &callback);
+
+            uint32_t announced = 0;
+
+        private:
+            struct Pending
+            {
+                uint16_t index;  // catalog index
+                uint8_t device;  // index into devices_
+            };
+
+            std::string config_payload(const DiscoveryInfo &meta, const Address &device, const std::string &node,
+                                       const std::string &state_topic);
+
+            std::string prefix_;
+            uint32_t interval_ = 1000;
+            uint8_t burst_ = 5;
+            uint8_t tokens_ = 0;
+            uint32_t last_refill_ = 0;
+
+            std::vector<Address> devices_;
+            std::vector<uint32_t> queued_; // one bit per catalog index, queued or announced
+            std::vector<Pending> pending_;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
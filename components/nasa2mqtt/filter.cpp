@@ -0,0 +1,109 @@
+#include <cstring>
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include "filter.h"
+#include "util.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        struct GroupName
+        {
+            const char *name;
+            MessageGroup group;
+        };
+
+        static const GroupName GROUP_NAMES[] = {
+            {"address", MessageGroup::Address},
+            {"network", MessageGroup::Network},
+            {"indoor", MessageGroup::Indoor},
+            {"outdoor", MessageGroup::Outdoor},
+            {"fsv", MessageGroup::Fsv},
+        };
+
+        void PublishFilter::setup(const std::string &key)
+        {
+            // a different catalog means different bit positions, so it gets its own slot
+            pref_ = global_preferences->make_preference<FilterState>(fnv1_hash("nasa2mqtt_filter_" + key) ^ catalog_size());
+            FilterState stored;
+            if (pref_.load(&stored))
+            {
+                bits_ = stored;
+                ESP_LOGI(TAG, "Restored publish filter");
+            }
+        }
+
+        void PublishFilter::set(size_t index, bool enabled)
+        {
+            if (enabled)
+                bits_.words[index / 32] |= 1UL << (index % 32);
+            else
+                bits_.words[index / 32] &= ~(1UL << (index % 32));
+        }
+
+        void PublishFilter::apply(const std::string &payload)
+        {
+            FilterState before = bits_;
+
+            size_t start = 0;
+            while (start < payload.length())
+            {
+                size_t end = payload.find_first_of(" ,", start);
+                if (end == std::string::npos)
+                    end = payload.length();
+                std::string token = payload.substr(start, end - start);
+                start = end + 1;
+
+                if (token.length() < 2 || (token[0] != '+' && token[0] != '-'))
+                {
+                    if (!token.empty())
+                        ESP_LOGW(TAG, "Invalid filter token '%s'", token.c_str());
+                    continue;
+                }
+
+                bool enabled = token[0] == '+';
+                std::string name = token.substr(1);
+
+                if (name == "all")
+                {
+                    for (size_t index = 0; index < catalog_size(); index++)
+                        set(index, enabled);
+                    continue;
+                }
+
+                bool group_found = false;
+                for (auto const &group : GROUP_NAMES)
+                {
+                    if (name != group.name)
+                        continue;
+                    for (size_t index = 0; index < catalog_size(); index++)
+                    {
+                        if (catalog_entry(index).group == group.group)
+                            set(index, enabled);
+                    }
+                    group_found = true;
+                }
+                if (group_found)
+                    continue;
+
+                const MessageInfo *info = find_message_info((MessageNumber)hex_to_int(name));
+                if (info == nullptr)
+                {
+                    ESP_LOGW(TAG, "Unknown message in filter token '%s'", token.c_str());
+                    continue;
+                }
+                set(catalog_index(*info), enabled);
+            }
+
+            if (memcmp(&before, &bits_, sizeof(bits_)) != 0)
+            {
+                ESP_LOGI(TAG, "Publish filter changed, saving");
+                pref_.save(&bits_);
+            }
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
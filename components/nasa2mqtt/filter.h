@@ -0,0 +1,48 @@
+#pragma once
+
+#include "esphome/core/preferences.h"
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Runtime on/off switch per catalog message, changed through a retained MQTT control topic and kept in flash.
+        class PublishFilter
+        {
+        public:
+            PublishFilter()
+            {
+                for (auto &word : bits_.words)
+                    word = 0xFFFFFFFF;
+            }
+
+            // Restores the filter from flash. key tells the buses apart.
+            void setup(const std::string &key);
+
+            bool enabled(const MessageInfo &info)
+            {
+                size_t index = catalog_index(info);
+                return (bits_.words[index / 32] >> (index % 32)) & 1;
+            }
+
+            // Space or comma separated tokens, applied in order: +<hex>/-<hex> for one message,
+            // +<group>/-<group> for a catalog group and +all/-all for everything.
+            void apply(const std::string &payload);
+
+        private:
+            static const size_t MAX_WORDS = MAX_CATALOG_SIZE / 32;
+
+            struct FilterState
+            {
+                uint32_t words[MAX_WORDS];
+            };
+
+            void set(size_t index, bool enabled);
+
+            FilterState bits_ = {};
+            ESPPreferenceObject pref_;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
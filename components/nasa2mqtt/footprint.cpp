@@ -0,0 +1,96 @@
+#include "footprint.h"
+#include "mqtt.h"
+
+#ifdef USE_ESP8266
+#include <Arduino.h>
+#elif defined(USE_ESP32)
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        static const char *const NAMES[] = {"heap_free", "heap_min_free", "heap_max_block", "heap_used", "heap_peak",
+                                            "loop_stack_free", "mqtt_stack_free", "frame_allocations_max",
+                                            "frames", "frame_allocations", "mqtt_outbox", "mqtt_outbox_peak",
+                                            "mqtt_refused", "mqtt_enqueue_max_us", "mqtt_inflight",
+                                            "mqtt_retransmitted", "mqtt_puback_avg_us", "mqtt_puback_max_us"};
+        static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == (size_t)FootprintValue::Count, "one name per value");
+
+        std::atomic<uint32_t> heap_allocations{0};
+        bool heap_allocations_counted = false;
+        Footprint footprint;
+
+        void Footprint::frame_end()
+        {
+#ifdef USE_ESP8266
+            // the core does not keep a low water mark, right after a frame is as low as the loop gets
+            set_min(FootprintValue::HeapMinFree, ESP.getFreeHeap());
+#endif
+            if (!heap_allocations_counted)
+                return;
+            uint32_t allocations = heap_allocations.load(std::memory_order_relaxed) - frame_allocations_;
+            set(FootprintValue::Frames, get(FootprintValue::Frames) + 1);
+            set(FootprintValue::FrameAllocations, get(FootprintValue::FrameAllocations) + allocations);
+            set_max(FootprintValue::FrameAllocationsMax, allocations);
+        }
+
+        void Footprint::sample()
+        {
+#ifdef USE_ESP8266
+            uint32_t free = ESP.getFreeHeap();
+            set(FootprintValue::HeapFree, free);
+            set_min(FootprintValue::HeapMinFree, free);
+            set(FootprintValue::HeapMaxBlock, ESP.getMaxFreeBlockSize());
+            // the loop and the publisher share the cont stack, painted at boot
+            set(FootprintValue::LoopStackFree, ESP.getFreeContStack());
+#elif defined(USE_ESP32)
+            set(FootprintValue::HeapFree, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+            set(FootprintValue::HeapMinFree, heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+            set(FootprintValue::HeapMaxBlock, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            // in bytes on ESP-IDF
+            set(FootprintValue::LoopStackFree, uxTaskGetStackHighWaterMark(nullptr));
+            TaskHandle_t mqtt_task = xTaskGetHandle("mqtt_task");
+            if (mqtt_task != nullptr)
+                set(FootprintValue::MqttStackFree, uxTaskGetStackHighWaterMark(mqtt_task));
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+            uint32_t used = mallinfo2().uordblks;
+            set(FootprintValue::HeapUsed, used);
+            set_max(FootprintValue::HeapPeak, used);
+#endif
+            const MqttOutbox &outbox = mqtt_outbox();
+            if (outbox.limit > 0)
+            {
+                set(FootprintValue::MqttOutbox, outbox.depth);
+                set(FootprintValue::MqttOutboxPeak, outbox.peak);
+            }
+            set(FootprintValue::MqttRefused, outbox.refused);
+            set(FootprintValue::MqttEnqueueMax, outbox.enqueue_us.max);
+            const MqttQos1 &qos1 = mqtt_qos1();
+            set(FootprintValue::MqttInflight, qos1.inflight);
+            set(FootprintValue::MqttRetransmitted, qos1.retransmitted);
+            set(FootprintValue::MqttPubackAvg, qos1.puback_us.count > 0 ? qos1.puback_us.total / qos1.puback_us.count : 0);
+            set(FootprintValue::MqttPubackMax, qos1.puback_us.max);
+        }
+
+        std::string Footprint::stats_to_json()
+        {
+            std::string json = "{";
+            for (size_t i = 0; i < (size_t)FootprintValue::Count; i++)
+            {
+                if (!available((FootprintValue)i))
+                    continue;
+                if (json.length() > 1)
+                    json += ",";
+                json += "\"" + std::string(NAMES[i]) + "\":" + std::to_string(get((FootprintValue)i));
+            }
+            return json + "}";
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
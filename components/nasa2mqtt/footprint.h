@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Operator new calls of the whole process. Only counted where the allocator is hooked
+        // (linux/alloc_hook.cpp, in the daemon and the host tools), 0 everywhere else.
+        extern std::atomic<uint32_t> heap_allocations;
+        extern bool heap_allocations_counted;
+
+        enum class FootprintValue : uint8_t
+        {
+            HeapFree = 0,
+            HeapMinFree,
+            HeapMaxBlock, // largest free block, fragmentation shows as this shrinking while free heap does not
+            HeapUsed,
+            HeapPeak,
+            LoopStackFree,      // least free stack ever seen in the task running the bus loop
+            MqttStackFree,      // same for the MQTT client task where it has one
+            FrameAllocationsMax, // most allocations while processing one frame
+            Frames,             // frames processed
+            FrameAllocations,   // allocations while processing them
+            MqttOutbox,         // the other process wide buffer, in the unit of mqtt_outbox()
+            MqttOutboxPeak,
+            MqttRefused,
+            MqttEnqueueMax,     // us
+            MqttInflight,       // QoS 1 messages waiting for their PUBACK
+            MqttRetransmitted,
+            MqttPubackAvg,      // us, send to PUBACK
+            MqttPubackMax,
+            Count
+        };
+
+        // Heap and stack use of the gateway, process wide. Written from the bus loop, read by
+        // metrics scrapes from another task, hence atomics. Values the platform cannot tell
+        // are left out of the stats and the metrics.
+        class Footprint
+        {
+        public:
+            // Around the processing of one frame
+            void frame_begin()
+            {
+                frame_allocations_ = heap_allocations.load(std::memory_order_relaxed);
+            }
+            void frame_end();
+
+            // Reads heap and stack figures of the platform, some of which walk the heap:
+            // call it every update interval, not per frame
+            void sample();
+
+            bool available(FootprintValue value) const
+            {
+                return (available_ >> (size_t)value) & 1;
+            }
+            uint32_t get(FootprintValue value) const
+            {
+                return values_[(size_t)value].load(std::memory_order_relaxed);
+            }
+
+            std::string stats_to_json();
+
+        private:
+            void set(FootprintValue value, uint32_t v)
+            {
+                available_ |= 1u << (size_t)value;
+                values_[(size_t)value].store(v, std::memory_order_relaxed);
+            }
+            void set_min(FootprintValue value, uint32_t v)
+            {
+                if (!available(value) || v < get(value))
+                    set(value, v);
+            }
+            void set_max(FootprintValue value, uint32_t v)
+            {
+                if (!available(value) || v > get(value))
+                    set(value, v);
+            }
+
+            std::atomic<uint32_t> available_{0};
+            std::atomic<uint32_t> values_[(size_t)FootprintValue::Count] = {};
+            uint32_t frame_allocations_ = 0;
+        };
+
+        extern Footprint footprint;
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include "esphome/core/log.h"
+#include "history.h"
+#include "util.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        static const uint32_t DEFAULT_QUERY_SECONDS = 3600;
+
+        static uint64_t zigzag(int64_t value)
+        {
+            return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+        }
+
+        static int64_t unzigzag(uint64_t value)
+        {
+            return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+        }
+
+        // 7 bits per byte, low bits first, high bit set on all but the last byte
+        static size_t put_varint(uint8_t *out, uint64_t value)
+        {
+            size_t length = 0;
+            while (value >= 0x80)
+            {
+                out[length++] = (uint8_t)value | 0x80;
+                value >>= 7;
+            }
+            out[length++] = (uint8_t)value;
+            return length;
+        }
+
+        static uint64_t get_varint(const uint8_t *&in)
+        {
+            uint64_t value = 0;
+            for (int shift = 0;; shift += 7)
+            {
+                uint8_t byte = *in++;
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+        }
+
+        HistorySeries::HistorySeries(MessageNumber messageNumber, size_t bytes, uint32_t interval)
+            : messageNumber(messageNumber), interval_(interval)
+        {
+            blocks_.resize(std::max<size_t>(2, (bytes + BLOCK_SIZE - 1) / BLOCK_SIZE));
+        }
+
+        bool HistorySeries::encode(Block &block, uint32_t now, int32_t value)
+        {
+            const int32_t delta = (int32_t)(now - tail_.time);
+            const bool changed = value != tail_.value;
+
+            uint8_t sample[20];
+            size_t length = put_varint(sample, zigzag((int64_t)delta - tail_.delta) << 1 | (changed ? 1 : 0));
+            if (changed)
+                length += put_varint(sample + length, zigzag((int64_t)value - tail_.value));
+            if (block.used + length > BLOCK_SIZE)
+                return false;
+
+            std::copy(sample, sample + length, block.data + block.used);
+            block.used += length;
+            block.count++;
+            tail_ = {now, delta, value};
+            return true;
+        }
+
+        void HistorySeries::append(uint32_t now, int32_t value)
+        {
+            if (filled_ > 0)
+            {
+                if (now - tail_.time < interval_)
+                    return;
+                if (encode(blocks_[newest_], now, value))
+                    return;
+                newest_ = (newest_ + 1) % blocks_.size();
+            }
+
+            // new block, overwriting the oldest once all are in use
+            Block &block = blocks_[newest_];
+            block.first_time = now;
+            block.first_value = value;
+            block.used = 0;
+            block.count = 1;
+            filled_ = std::min(filled_ + 1, blocks_.size());
+            tail_ = {now, 0, value};
+        }
+
+        void HistorySeries::read(uint32_t since, std::vector<uint32_t> &times, std::vector<int32_t> &values)
+        {
+            const size_t oldest = (newest_ + blocks_.size() + 1 - filled_) % blocks_.size();
+            for (size_t i = 0; i < filled_; i++)
+            {
+                const Block &block = blocks_[(oldest + i) % blocks_.size()];
+                uint32_t time = block.first_time;
+                int32_t value = block.first_value;
+                int32_t delta = 0;
+                const uint8_t *in = block.data;
+                for (uint16_t sample = 0; sample < block.count; sample++)
+                {
+                    if (sample > 0)
+                    {
+                        uint64_t header = get_varint(in);
+                        delta += (int32_t)unzigzag(header >> 1);
+                        time += delta;
+                        if (header & 1)
+                            value += (int32_t)unzigzag(get_varint(in));
+                    }
+                    if ((int32_t)(time - since) >= 0)
+                    {
+                        times.push_back(time);
+                        values.push_back(value);
+                    }
+                }
+            }
+        }
+
+        size_t HistorySeries::samples()
+        {
+            size_t count = 0;
+            const size_t oldest = (newest_ + blocks_.size() + 1 - filled_) % blocks_.size();
+            for (size_t i = 0; i < filled_; i++)
+                count += blocks_[(oldest + i) % blocks_.size()].count;
+            return count;
+        }
+
+        size_t HistorySeries::memory()
+        {
+            return blocks_.size() * sizeof(Block);
+        }
+
+        void History::add_series(MessageNumber messageNumber, size_t bytes, uint32_t interval)
+        {
+            const MessageInfo *info = find_message_info(messageNumber);
+            if (info == nullptr)
+            {
+                ESP_LOGW(TAG, "History: message %s is not decoded, ignoring it", long_to_hex((uint16_t)messageNumber).c_str());
+                return;
+            }
+            if (find(messageNumber) != nullptr)
+                return;
+
+            series_.emplace_back(messageNumber, bytes, interval);
+            series_of_.resize(catalog_size(), 0);
+            series_of_[catalog_index(*info)] = series_.size();
+        }
+
+        HistorySeries *History::find(MessageNumber messageNumber)
+        {
+            for (auto &series : series_)
+            {
+                if (series.messageNumber == messageNumber)
+                    return &series;
+            }
+            return nullptr;
+        }
+
+        void History::add(const MessageInfo &info, int32_t value, uint32_t now_ms)
+        {
+            if (series_.empty())
+                return;
+            uint16_t series = series_of_[catalog_index(info)];
+            if (series != 0)
+                series_[series - 1].append(now_ms / 1000, value);
+        }
+
+        static void put_be(std::string &out, uint32_t value, size_t bytes)
+        {
+            while (bytes-- > 0)
+                out += (char)(value >> (8 * bytes));
+        }
+
+        bool History::query(const std::string &request, uint32_t now_ms, std::string &suffix, std::string &payload)
+        {
+            char number[8] = {};
+            char format[8] = "json";
+            unsigned long seconds = DEFAULT_QUERY_SECONDS;
+            if (sscanf(request.c_str(), "%7s %lu %7s", number, &seconds, format) < 1)
+                return false;
+
+            HistorySeries *series = find((MessageNumber)strtol(number, nullptr, 16));
+            if (series == nullptr)
+                return false;
+            const bool binary = std::string(format) == "binary";
+            if (!binary && std::string(format) != "json")
+                return false;
+            queries_++;
+
+            const uint32_t now = now_ms / 1000;
+            std::vector<uint32_t> times;
+            std::vector<int32_t> values;
+            series->read(seconds >= now ? 0 : now - seconds, times, values);
+
+            const std::string hex = long_to_hex((uint16_t)series->messageNumber);
+            suffix = "nasa2mqtt/history/" + hex;
+            if (binary)
+            {
+                payload = "NH";
+                payload += (char)1;
+                put_be(payload, (uint16_t)series->messageNumber, 2);
+                put_be(payload, now, 4);
+                put_be(payload, times.size(), 2);
+                uint32_t time = 0;
+                int32_t value = 0;
+                uint8_t varint[10];
+                for (size_t i = 0; i < times.size(); i++)
+                {
+                    payload.append((const char *)varint, put_varint(varint, zigzag((int64_t)times[i] - time)));
+                    payload.append((const char *)varint, put_varint(varint, zigzag((int64_t)values[i] - value)));
+                    time = times[i];
+                    value = values[i];
+                }
+                return true;
+            }
+
+            payload = "{\"message\":\"" + hex + "\",\"now\":" + std::to_string(now) + ",\"samples\":[";
+            for (size_t i = 0; i < times.size(); i++)
+            {
+                if (i > 0)
+                    payload += ",";
+                payload += "[" + std::to_string(now - times[i]) + "," + std::to_string(values[i]) + "]";
+            }
+            payload += "]}";
+            return true;
+        }
+
+        std::string History::stats_to_json()
+        {
+            size_t samples = 0;
+            size_t bytes = 0;
+            for (auto &series : series_)
+            {
+                samples += series.samples();
+                bytes += series.memory();
+            }
+            return "{\"series\":" + std::to_string(series_.size()) +
+                   ",\"samples\":" + std::to_string(samples) +
+                   ",\"bytes\":" + std::to_string(bytes) +
+                   ",\"queries\":" + std::to_string(queries_) + "}";
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Samples of one message in a fixed number of fixed size blocks, the oldest block is
+        // overwritten when the newest one is full. Inside a block each sample is
+        //   varint(zigzag(delta of delta of the time in s) << 1 | value changed)
+        //   [varint(zigzag(value - previous value))]   only when changed
+        // so a sample at the usual interval with an unchanged value takes one byte.
+        class HistorySeries
+        {
+        public:
+            static const size_t BLOCK_SIZE = 128;
+
+            // bytes is rounded up to whole blocks, at least two
+            HistorySeries(MessageNumber messageNumber, size_t bytes, uint32_t interval);
+
+            MessageNumber messageNumber;
+
+            // now in s; samples closer than interval to the previous one are skipped
+            void append(uint32_t now, int32_t value);
+
+            // Samples with a time >= since, oldest first
+            void read(uint32_t since, std::vector<uint32_t> &times, std::vector<int32_t> &values);
+
+            size_t samples();
+            size_t memory();
+
+        private:
+            struct Block
+            {
+                uint32_t first_time;
+                int32_t first_value;
+                uint16_t used = 0; // bytes in data
+                uint16_t count = 0;
+                uint8_t data[BLOCK_SIZE];
+            };
+
+            // state of the newest block, for the next append
+            struct Tail
+            {
+                uint32_t time;
+                int32_t delta;
+                int32_t value;
+            };
+
+            bool encode(Block &block, uint32_t now, int32_t value);
+
+            std::vector<Block> blocks_;
+            size_t newest_ = 0;
+            size_t filled_ = 0; // blocks with samples
+            uint32_t interval_;
+            Tail tail_ = {};
+        };
+
+        // Series for the messages selected in yaml, fed from the publisher and read through
+        // the MQTT query <prefix>/nasa2mqtt/history/get
+        class History
+        {
+        public:
+            void add_series(MessageNumber messageNumber, size_t bytes, uint32_t interval);
+            bool enabled()
+            {
+                return !series_.empty();
+            }
+
+            bool has_series(const MessageInfo &info)
+            {
+                return !series_.empty() && series_of_[catalog_index(info)] != 0;
+            }
+
+            void add(const MessageInfo &info, int32_t value, uint32_t now_ms);
+
+            // Query "<hex message> [seconds back, default 3600] [json|binary]". Returns false when the
+            // query makes no sense, otherwise topic suffix and payload of the answer:
+            // json:   {"message":"4236","now":<uptime s>,"samples":[[<age s>,<value>],...]}
+            // binary: "NH", version 1, message (2 bytes), now (4), count (2), all big endian,
+            //         then per sample varint(zigzag(time delta)) varint(zigzag(value delta)),
+            //         both relative to the previous sample (the first one to 0)
+            bool query(const std::string &request, uint32_t now_ms, std::string &suffix, std::string &payload);
+
+            std::string stats_to_json();
+
+        private:
+            HistorySeries *find(MessageNumber messageNumber);
+
+            std::vector<HistorySeries> series_;
+            std::vector<uint16_t> series_of_; // by catalog index
+            uint32_t queries_ = 0;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,107 @@
+#include "limiter.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        void RateLimiter::add_limit(MessageNumber messageNumber, uint32_t interval, uint8_t burst)
+        {
+            const MessageInfo *info = find_message_info(messageNumber);
+            if (info == nullptr)
+                return;
+
+            limits_.push_back({interval, burst});
+            set_limit(catalog_index(*info), limits_.size() - 1);
+        }
+
+        void RateLimiter::add_limit(MessageGroup group, uint32_t interval, uint8_t burst)
+        {
+            limits_.push_back({interval, burst});
+            for (size_t index = 0; index < catalog_size(); index++)
+            {
+                if (catalog_entry(index).group == group)
+                    set_limit(index, limits_.size() - 1);
+            }
+        }
+
+        void RateLimiter::set_limit(size_t index, uint8_t limit)
+        {
+            if (bucket_of_.empty())
+                bucket_of_.resize(catalog_size(), NO_BUCKET);
+
+            // a later limit for the same message replaces the earlier one
+            if (bucket_of_[index] == NO_BUCKET)
+            {
+                bucket_of_[index] = buckets_.size();
+                buckets_.push_back({});
+            }
+
+            TokenBucket &bucket = buckets_[bucket_of_[index]];
+            bucket.index = index;
+            bucket.limit = limit;
+            bucket.tokens = limits_[limit].burst;
+            bucket.pending = false;
+        }
+
+        void RateLimiter::refill(TokenBucket &bucket, uint32_t now)
+        {
+            const Limit &limit = limits_[bucket.limit];
+            if (bucket.tokens >= limit.burst)
+            {
+                bucket.last_refill = now;
+                return;
+            }
+
+            uint32_t due = (now - bucket.last_refill) / limit.interval;
+            if (due == 0)
+                return;
+
+            bucket.last_refill += due * limit.interval;
+            bucket.tokens = due >= (uint32_t)(limit.burst - bucket.tokens) ? limit.burst : bucket.tokens + due;
+        }
+
+        bool RateLimiter::allow(const MessageInfo &info, long value, uint32_t decoded_at, uint32_t now)
+        {
+            if (bucket_of_.empty())
+                return true;
+
+            uint16_t index = bucket_of_[catalog_index(info)];
+            if (index == NO_BUCKET)
+                return true;
+
+            TokenBucket &bucket = buckets_[index];
+            refill(bucket, now);
+            if (bucket.tokens > 0)
+            {
+                bucket.tokens--;
+                bucket.pending = false;
+                return true;
+            }
+
+            if (bucket.pending)
+                limited++; // the previously held back value is superseded
+            bucket.value = value;
+            bucket.decoded_at = decoded_at;
+            bucket.pending = true;
+            return false;
+        }
+
+        void RateLimiter::flush(uint32_t now, const FlushCallback &callback)
+        {
+            for (auto &bucket : buckets_)
+            {
+                if (!bucket.pending)
+                    continue;
+
+                refill(bucket, now);
+                if (bucket.tokens == 0)
+                    continue;
+
+                bucket.tokens--;
+                bucket.pending = false;
+                callback(catalog_entry(bucket.index).messageNumber, bucket.value, bucket.decoded_at);
+            }
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Token bucket per limited message: a burst of values goes out immediately, after that one
+        // per interval. Values arriving without a token are not lost, the latest one is published
+        // as soon as the next token is due.
+        class RateLimiter
+        {
+        public:
+            using FlushCallback = std::function<void(MessageNumber messageNumber, long value, uint32_t decoded_at)>;
+
+            void add_limit(MessageNumber messageNumber, uint32_t interval, uint8_t burst);
+            void add_limit(MessageGroup group, uint32_t interval, uint8_t burst);
+
+            // Returns true when the value may be published now, otherwise it is kept for flush()
+            bool allow(const MessageInfo &info, long value, uint32_t decoded_at, uint32_t now);
+            // Publishes held back values whose token is due
+            void flush(uint32_t now, const FlushCallback &callback);
+
+            uint32_t limited = 0;
+
+        private:
+            struct Limit
+            {
+                uint32_t interval;
+                uint8_t burst;
+            };
+
+            struct TokenBucket
+            {
+                uint32_t last_refill;
+                uint32_t decoded_at; // of the held back value
+                int32_t value;
+                uint16_t index;      // catalog index
+                uint8_t limit;       // index into limits_
+                uint8_t tokens : 7;
+                bool pending : 1;
+            };
+
+            static constexpr uint16_t NO_BUCKET = 0xFFFF;
+
+            void set_limit(size_t index, uint8_t limit);
+            void refill(TokenBucket &bucket, uint32_t now);
+
+            std::vector<Limit> limits_;
+            std::vector<TokenBucket> buckets_;
+            std::vector<uint16_t> bucket_of_; // by catalog index
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
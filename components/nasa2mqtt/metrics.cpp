@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "metrics.h"
+#include "footprint.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        struct CounterFamily
+        {
+            const char *name;
+            const char *help;
+        };
+
+        // in MetricsCounter order
+        static const CounterFamily COUNTER_FAMILIES[] = {
+            {"nasa2mqtt_published", "Messages published to MQTT"},
+            {"nasa2mqtt_dropped", "Messages lost because MQTT was down or refused them"},
+            {"nasa2mqtt_rate_limited", "Values held back by a rate limit"},
+            {"nasa2mqtt_deferred", "Values held back while the MQTT outbox was congested"},
+            {"nasa2mqtt_requests_sent", "Read requests sent on the bus"},
+            {"nasa2mqtt_responses", "Responses to read requests"},
+            {"nasa2mqtt_request_timeouts", "Read requests that got no response"},
+            {"nasa2mqtt_write_commands", "Write commands received over MQTT"},
+            {"nasa2mqtt_write_acks", "Writes acknowledged by the unit"},
+            {"nasa2mqtt_write_nacks", "Writes refused by the unit"},
+            {"nasa2mqtt_write_retries", "Writes sent again after a timeout"},
+            {"nasa2mqtt_write_failures", "Writes given up after the last retry"},
+            {"nasa2mqtt_frames_lost", "Gaps in the packet numbers of the devices on the bus"},
+            {"nasa2mqtt_retransmissions", "Repeated frames dropped before decoding"},
+            {"nasa2mqtt_dedup_lookups", "Notifications checked against the last frame of their kind"},
+            {"nasa2mqtt_dedup_hits", "Notifications identical to the last of their kind, not decoded"},
+        };
+        static_assert(sizeof(COUNTER_FAMILIES) / sizeof(COUNTER_FAMILIES[0]) == (size_t)MetricsCounter::Count,
+                      "one family per counter");
+
+        struct FootprintFamily
+        {
+            const char *name;
+            const char *help;
+            bool counter;
+        };
+
+        // in FootprintValue order, process wide so without a bus label
+        static const FootprintFamily FOOTPRINT_FAMILIES[] = {
+            {"nasa2mqtt_heap_free_bytes", "Free heap", false},
+            {"nasa2mqtt_heap_min_free_bytes", "Lowest free heap since boot", false},
+            {"nasa2mqtt_heap_max_block_bytes", "Largest free heap block", false},
+            {"nasa2mqtt_heap_used_bytes", "Heap in use", false},
+            {"nasa2mqtt_heap_peak_bytes", "Most heap in use at an update", false},
+            {"nasa2mqtt_loop_stack_free_bytes", "Least free stack of the bus loop task", false},
+            {"nasa2mqtt_mqtt_stack_free_bytes", "Least free stack of the MQTT client task", false},
+            {"nasa2mqtt_frame_allocations_max", "Most heap allocations while processing one frame", false},
+            {"nasa2mqtt_frames_measured", "Frames processed with allocation counting", true},
+            {"nasa2mqtt_frame_allocations", "Heap allocations while processing frames", true},
+            {"nasa2mqtt_mqtt_outbox", "Bytes (ESP32) or messages (daemon) waiting in the MQTT client outbox", false},
+            {"nasa2mqtt_mqtt_outbox_peak", "Fullest the MQTT client outbox has been", false},
+            {"nasa2mqtt_mqtt_refused", "Publishes the MQTT client refused to enqueue", true},
+            {"nasa2mqtt_mqtt_enqueue_max_us", "Longest time handing a message to the MQTT client took", false},
+            {"nasa2mqtt_mqtt_inflight", "QoS 1 messages sent and waiting for their PUBACK", false},
+            {"nasa2mqtt_mqtt_retransmitted", "QoS 1 messages sent again for want of a PUBACK", true},
+            {"nasa2mqtt_mqtt_puback_avg_us", "Average time from sending a QoS 1 message to its PUBACK", false},
+            {"nasa2mqtt_mqtt_puback_max_us", "Longest time from sending a QoS 1 message to its PUBACK", false},
+        };
+        static_assert(sizeof(FOOTPRINT_FAMILIES) / sizeof(FOOTPRINT_FAMILIES[0]) == (size_t)FootprintValue::Count,
+                      "one family per footprint value");
+
+        static std::vector<MetricsSnapshot *> snapshots;
+
+        void register_metrics(MetricsSnapshot *snapshot)
+        {
+            snapshots.push_back(snapshot);
+        }
+
+        MetricsSnapshot::MetricsSnapshot() : values_(catalog_size()), seen_((catalog_size() + 31) / 32)
+        {
+            for (auto &value : values_)
+                value.store(0, std::memory_order_relaxed);
+            for (auto &word : seen_)
+                word.store(0, std::memory_order_relaxed);
+            for (auto &counter : counters_)
+                counter.store(0, std::memory_order_relaxed);
+        }
+
+        void MetricsSnapshot::set_value(const MessageInfo &info, int32_t value)
+        {
+            size_t index = catalog_index(info);
+            uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+
+            // odd while writing
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            values_[index].store(value, std::memory_order_relaxed);
+            seen_[index / 32].store(seen_[index / 32].load(std::memory_order_relaxed) | (1u << (index % 32)), std::memory_order_relaxed);
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        MetricsRenderer::MetricsRenderer()
+        {
+            views_.resize(snapshots.size());
+            for (size_t i = 0; i < snapshots.size(); i++)
+            {
+                const MetricsSnapshot &snapshot = *snapshots[i];
+                View &view = views_[i];
+                view.source = &snapshot;
+                view.values.resize(snapshot.values_.size());
+                view.seen.resize(snapshot.seen_.size());
+
+                // retry until no write overlapped the copy
+                uint32_t before, after;
+                do
+                {
+                    before = snapshot.sequence_.load(std::memory_order_acquire);
+                    for (size_t j = 0; j < view.values.size(); j++)
+                        view.values[j] = snapshot.values_[j].load(std::memory_order_relaxed);
+                    for (size_t j = 0; j < view.seen.size(); j++)
+                        view.seen[j] = snapshot.seen_[j].load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    after = snapshot.sequence_.load(std::memory_order_relaxed);
+                } while ((before & 1) || before != after);
+
+                for (size_t j = 0; j < (size_t)MetricsCounter::Count; j++)
+                    view.counters[j] = snapshot.counters_[j].load(std::memory_order_relaxed);
+            }
+        }
+
+        size_t MetricsRenderer::render(char *buffer, size_t size)
+        {
+            size_t written = 0;
+            while (written < size)
+            {
+                if (line_offset_ == line_length_)
+                {
+                    if (!next_line())
+                        break;
+                    line_offset_ = 0;
+                }
+
+                size_t chunk = std::min(line_length_ - line_offset_, size - written);
+                memcpy(buffer + written, line_ + line_offset_, chunk);
+                line_offset_ += chunk;
+                written += chunk;
+            }
+            return written;
+        }
+
+        bool MetricsRenderer::next_line()
+        {
+            int length = 0;
+            while (length == 0)
+            {
+                switch (stage_)
+                {
+                case Stage::ValueType:
+                    length = snprintf(line_, sizeof(line_), "# TYPE nasa_value gauge\n");
+                    stage_ = Stage::ValueHelp;
+                    break;
+
+                case Stage::ValueHelp:
+                    length = snprintf(line_, sizeof(line_), "# HELP nasa_value Latest raw value of a NASA message\n");
+                    stage_ = Stage::Value;
+                    view_ = 0;
+                    entry_ = 0;
+                    break;
+
+                case Stage::Value:
+                    if (view_ == views_.size())
+                    {
+                        stage_ = Stage::CounterType;
+                        counter_ = 0;
+                        break;
+                    }
+                    if (entry_ == views_[view_].values.size())
+                    {
+                        view_++;
+                        entry_ = 0;
+                        break;
+                    }
+                    if ((views_[view_].seen[entry_ / 32] >> (entry_ % 32)) & 1)
+                    {
+                        length = snprintf(line_, sizeof(line_), "nasa_value{bus=\"%.48s\",message=\"0x%04x\"} %d\n",
+                                          views_[view_].source->bus.c_str(),
+                                          (uint16_t)catalog_entry(entry_).messageNumber,
+                                          (int)views_[view_].values[entry_]);
+                    }
+                    entry_++;
+                    break;
+
+                case Stage::CounterType:
+                    if (counter_ == (size_t)MetricsCounter::Count)
+                    {
+                        stage_ = Stage::FootprintType;
+                        entry_ = 0;
+                        break;
+                    }
+                    length = snprintf(line_, sizeof(line_), "# TYPE %s counter\n", COUNTER_FAMILIES[counter_].name);
+                    stage_ = Stage::CounterHelp;
+                    break;
+
+                case Stage::CounterHelp:
+                    length = snprintf(line_, sizeof(line_), "# HELP %s %s\n", COUNTER_FAMILIES[counter_].name, COUNTER_FAMILIES[counter_].help);
+                    stage_ = Stage::Counter;
+                    view_ = 0;
+                    break;
+
+                case Stage::Counter:
+                    if (view_ == views_.size())
+                    {
+                        stage_ = Stage::CounterType;
+                        counter_++;
+                        break;
+                    }
+                    length = snprintf(line_, sizeof(line_), "%s_total{bus=\"%.48s\"} %u\n", COUNTER_FAMILIES[counter_].name,
+                                      views_[view_].source->bus.c_str(), (unsigned)views_[view_].counters[counter_]);
+                    view_++;
+                    break;
+
+                case Stage::FootprintType:
+                    if (entry_ == (size_t)FootprintValue::Count)
+                    {
+                        stage_ = Stage::Eof;
+                        break;
+                    }
+                    if (!footprint.available((FootprintValue)entry_))
+                    {
+                        entry_++;
+                        break;
+                    }
+                    length = snprintf(line_, sizeof(line_), "# TYPE %s %s\n", FOOTPRINT_FAMILIES[entry_].name,
+                                      FOOTPRINT_FAMILIES[entry_].counter ? "counter" : "gauge");
+                    stage_ = Stage::FootprintHelp;
+                    break;
+
+                case Stage::FootprintHelp:
+                    length = snprintf(line_, sizeof(line_), "# HELP %s %s\n", FOOTPRINT_FAMILIES[entry_].name, FOOTPRINT_FAMILIES[entry_].help);
+                    stage_ = Stage::Footprint;
+                    break;
+
+                case Stage::Footprint:
+                    length = snprintf(line_, sizeof(line_), "%s%s %u\n", FOOTPRINT_FAMILIES[entry_].name,
+                                      FOOTPRINT_FAMILIES[entry_].counter ? "_total" : "",
+                                      (unsigned)footprint.get((FootprintValue)entry_));
+                    stage_ = Stage::FootprintType;
+                    entry_++;
+                    break;
+
+                case Stage::Eof:
+                    length = snprintf(line_, sizeof(line_), "# EOF\n");
+                    stage_ = Stage::Done;
+                    break;
+
+                case Stage::Done:
+                    return false;
+                }
+            }
+
+            // labels are bounded, this only guards the buffer
+            if (length >= (int)sizeof(line_))
+            {
+                length = sizeof(line_) - 1;
+                line_[length - 1] = '\n';
+            }
+            line_length_ = length;
+            return true;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
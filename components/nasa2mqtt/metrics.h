@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        enum class MetricsCounter : uint8_t
+        {
+            Published = 0,
+            Dropped,
+            RateLimited,
+            Deferred,
+            RequestsSent,
+            Responses,
+            RequestTimeouts,
+            WriteCommands,
+            WriteAcks,
+            WriteNacks,
+            WriteRetries,
+            WriteFailures,
+            FramesLost,
+            Retransmissions,
+            DedupLookups,
+            DedupHits,
+            Count
+        };
+
+        // Latest value of every catalog message plus the pipeline counters of one bus.
+        // Written by the bus loop only; read from the web server task through a seqlock,
+        // so a scrape never makes the loop wait.
+        class MetricsSnapshot
+        {
+        public:
+            MetricsSnapshot();
+
+            // Label of this bus in the exposition, its topic prefix
+            std::string bus;
+
+            void set_value(const MessageInfo &info, int32_t value);
+            void set_counter(MetricsCounter counter, uint32_t value)
+            {
+                counters_[(size_t)counter].store(value, std::memory_order_relaxed);
+            }
+
+        private:
+            friend class MetricsRenderer;
+
+            std::atomic<uint32_t> sequence_{0};
+            std::vector<std::atomic<int32_t>> values_;
+            std::vector<std::atomic<uint32_t>> seen_;
+            std::atomic<uint32_t> counters_[(size_t)MetricsCounter::Count];
+        };
+
+        // Makes a snapshot part of every scrape. Called once per bus during setup.
+        void register_metrics(MetricsSnapshot *snapshot);
+
+        // OpenMetrics text of all registered buses as of construction, followed by the process wide
+        // heap and stack figures as of rendering, handed out in pieces
+        // of at most the caller's buffer size, so no response is ever held in memory as a whole.
+        class MetricsRenderer
+        {
+        public:
+            MetricsRenderer();
+
+            // Returns the number of bytes written to buffer, 0 once the exposition is complete
+            size_t render(char *buffer, size_t size);
+
+        private:
+            struct View
+            {
+                const MetricsSnapshot *source;
+                std::vector<int32_t> values;
+                std::vector<uint32_t> seen;
+                uint32_t counters[(size_t)MetricsCounter::Count];
+            };
+
+            enum class Stage : uint8_t
+            {
+                ValueType,
+                ValueHelp,
+                Value,
+                CounterType,
+                CounterHelp,
+                Counter,
+                FootprintType,
+                FootprintHelp,
+                Footprint,
+                Eof,
+                Done
+            };
+
+            // Formats the next line into line_, false when there is none left
+            bool next_line();
+
+            std::vector<View> views_;
+            Stage stage_ = Stage::ValueType;
+            size_t counter_ = 0;
+            size_t view_ = 0;
+            size_t entry_ = 0;
+            char line_[128];
+            size_t line_length_ = 0;
+            size_t line_offset_ = 0;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
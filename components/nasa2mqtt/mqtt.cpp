@@ -1,13 +1,124 @@
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 #include "mqtt.h"
+#include <deque>
+
+// incoming messages and subscriptions are shared with the network task
+static std::vector<std::string> mqtt_subscriptions;
+static std::deque<esphome::nasa2mqtt::MqttMessage> mqtt_inbox;
+static const size_t MQTT_INBOX_SIZE = 16;
+
+#if defined(USE_ESP8266) || defined(USE_ESP32) || defined(USE_MOSQUITTO)
+static void mqtt_inbox_push(const std::string &topic, const std::string &payload);
+static void mqtt_qos1_acked(int msg_id);
+#endif
+
+static esphome::nasa2mqtt::MqttOutbox mqtt_outbox_state;
+static uint32_t mqtt_refused_at = 0;
+static bool mqtt_refused_recently = false;
+// where the outbox depth is unknown, a refused publish counts as congestion for this long
+static const uint32_t MQTT_REFUSED_BACKOFF_MS = 250;
+
+static std::string mqtt_tls_ca;
+static std::string mqtt_client_id;
+static bool mqtt_clean_session = true;
+
+// QoS 1 messages sent and waiting for their PUBACK, and those waiting for a slot in the window.
+// Both belong to the main loop, PUBACKs from another task are handed over (mqtt_acks).
+struct MqttQos1Message
+{
+    std::string topic;
+    std::string payload;
+    bool retain;
+    int msg_id;       // of the latest send, -1 when the client refused it
+    uint32_t sent_at; // micros() of the latest send
+};
+static std::vector<MqttQos1Message> mqtt_inflight;
+static std::deque<MqttQos1Message> mqtt_qos1_queue;
+static const size_t MQTT_QOS1_QUEUE_SIZE = 32;
+static uint8_t mqtt_inflight_window = 8;
+static uint32_t mqtt_retransmit_timeout = 5000; // ms
+static esphome::nasa2mqtt::MqttQos1 mqtt_qos1_state;
+static bool mqtt_qos1_connected = false; // as of the previous mqtt_loop
+
+// What a connect did with the TLS session of the previous one. Offered: a session ticket went out,
+// but the client cannot tell whether the broker took it or a full handshake followed.
+enum class MqttTlsResumption
+{
+    None,
+    Offered,
+    Resumed,
+};
+
+// Written by the network task, read for the stats only
+static struct
+{
+    uint32_t connects = 0;
+    uint32_t resumed = 0;
+    uint32_t offered = 0;
+    uint32_t full_ms = 0;    // sum over connects with a full handshake (or without TLS)
+    uint32_t resumed_ms = 0; // sum over connects that resumed the TLS session
+    uint32_t offered_ms = 0; // sum over connects that offered a session, outcome unknown
+    uint32_t last_ms = 0;
+    bool session_present = false;
+    uint32_t started = 0;
+} mqtt_connect_stats;
+
+// Called from the client callbacks, a build without an MQTT client has none
+#if defined(USE_ESP8266) || defined(USE_ESP32) || defined(USE_MOSQUITTO)
+static void mqtt_connect_started()
+{
+    mqtt_connect_stats.started = esphome::millis();
+}
+
+static void mqtt_connect_done(MqttTlsResumption resumption, bool session_present)
+{
+    const uint32_t took = esphome::millis() - mqtt_connect_stats.started;
+    mqtt_connect_stats.connects++;
+    mqtt_connect_stats.last_ms = took;
+    mqtt_connect_stats.session_present = session_present;
+    if (resumption == MqttTlsResumption::Resumed)
+    {
+        mqtt_connect_stats.resumed++;
+        mqtt_connect_stats.resumed_ms += took;
+    }
+    else if (resumption == MqttTlsResumption::Offered)
+    {
+        mqtt_connect_stats.offered++;
+        mqtt_connect_stats.offered_ms += took;
+    }
+    else
+        mqtt_connect_stats.full_ms += took;
+    ESP_LOGI("NASA2MQTT", "MQTT connected in %u ms%s%s", (unsigned)took,
+             resumption == MqttTlsResumption::Resumed ? ", TLS session resumed"
+             : resumption == MqttTlsResumption::Offered ? ", TLS session offered" : "",
+             session_present ? ", session present" : "");
+}
+#endif
 
 #ifdef USE_ESP8266
 #include <AsyncMqttClient.h>
 AsyncMqttClient *mqtt_client{nullptr};
 #endif
 #ifdef USE_ESP32
+#include <mutex>
 #include <mqtt_client.h>
 esp_mqtt_client_handle_t mqtt_client{nullptr};
+static std::mutex mqtt_inbox_lock;
+// PUBACKs from the MQTT task: msg_id and micros(). The client holds its own lock while it calls the
+// event handler, so the handler must not wait for the main loop, which publishes under that lock.
+static std::vector<std::pair<int, uint32_t>> mqtt_acks;
+static std::mutex mqtt_acks_lock;
+static const size_t MQTT_ACKS_SIZE = 64;
+// outbox bytes, beyond which esp-mqtt refuses to enqueue
+static const uint32_t MQTT_OUTBOX_LIMIT = 16 * 1024;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+#include <esp_transport_ssl.h>
+// Our own TLS transport, so the session ticket of one connect can be offered on the next
+static esp_transport_handle_t mqtt_tls_transport{nullptr};
+static bool mqtt_tls_ticket_saved = false;
+#endif
+static bool mqtt_tls_ticket_offered = false;
 
 static esp_err_t mqtt_event_handler(void *handler_args,
                                     esp_event_base_t base,
@@ -20,9 +131,29 @@ static esp_err_t mqtt_event_handler(void *handler_args,
     
     switch (event_id)
     {
+    case MQTT_EVENT_BEFORE_CONNECT:
+        mqtt_connect_started();
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        mqtt_tls_ticket_offered = mqtt_tls_transport != nullptr && mqtt_tls_ticket_saved;
+        if (mqtt_tls_ticket_offered)
+            esp_transport_ssl_session_ticket_operation(mqtt_tls_transport, ESP_TRANSPORT_SESSION_TICKET_USE);
+#endif
+        break;
     case MQTT_EVENT_CONNECTED:
-        ESP_LOGI("NASA2MQTT", "MQTT_EVENT_CONNECTED");
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (mqtt_tls_transport != nullptr)
+        {
+            esp_transport_ssl_session_ticket_operation(mqtt_tls_transport, ESP_TRANSPORT_SESSION_TICKET_SAVE);
+            mqtt_tls_ticket_saved = true;
+        }
+#endif
+        // mbedTLS falls back to a full handshake when the broker no longer knows the ticket, and
+        // esp_transport_ssl does not tell which one it was
+        mqtt_connect_done(mqtt_tls_ticket_offered ? MqttTlsResumption::Offered : MqttTlsResumption::None,
+                          event->session_present);
         esphome::nasa2mqtt::is_mqtt_connected = true;
+        for (auto const &topic : mqtt_subscriptions)
+            esp_mqtt_client_subscribe(event->client, topic.c_str(), 0);
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGW("NASA2MQTT", "MQTT_EVENT_DISCONNECTED");
@@ -30,6 +161,15 @@ static esp_err_t mqtt_event_handler(void *handler_args,
         break;
     case MQTT_EVENT_PUBLISHED:
         ESP_LOGV("NASA2MQTT", "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        mqtt_qos1_acked(event->msg_id);
+        break;
+    case MQTT_EVENT_SUBSCRIBED:
+        ESP_LOGV("NASA2MQTT", "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
+        break;
+    case MQTT_EVENT_DATA:
+        // commands are tiny, fragmented payloads are not supported
+        if (event->current_data_offset == 0 && event->data_len == event->total_data_len)
+            mqtt_inbox_push(std::string(event->topic, event->topic_len), std::string(event->data, event->data_len));
         break;
     case MQTT_EVENT_ERROR:
         ESP_LOGE("NASA2MQTT", "MQTT_EVENT_ERROR, error_code=%d", event->error_handle->error_type);
@@ -41,6 +181,95 @@ static esp_err_t mqtt_event_handler(void *handler_args,
     return ESP_OK;
 }
 #endif   
+#ifdef USE_MOSQUITTO
+#include <mosquitto.h>
+#include "tls_session.h"
+// Linux daemon: libmosquitto driven by the daemon's event loop, so no locking needed
+struct mosquitto *mqtt_client{nullptr};
+static bool mqtt_client_connected = false;
+static SSL_CTX *mqtt_tls_context{nullptr};
+// messages libmosquitto has queued but not written yet; it would queue without bound
+static const uint32_t MQTT_OUTBOX_LIMIT = 256;
+
+static void mqtt_on_publish(struct mosquitto *mosq, void *obj, int mid)
+{
+    if (mqtt_outbox_state.depth > 0)
+        mqtt_outbox_state.depth--;
+    mqtt_qos1_acked(mid);
+}
+
+static void mqtt_on_connect(struct mosquitto *mosq, void *obj, int rc, int flags)
+{
+    if (rc != 0)
+    {
+        ESP_LOGW("NASA2MQTT", "MQTT connect failed: %s", mosquitto_connack_string(rc));
+        return;
+    }
+    SSL *ssl = (SSL *)mosquitto_ssl_get(mosq);
+    mqtt_connect_done(ssl != nullptr && SSL_session_reused(ssl) ? MqttTlsResumption::Resumed : MqttTlsResumption::None,
+                      flags & 1);
+    mqtt_client_connected = true;
+    for (auto const &topic : mqtt_subscriptions)
+        mosquitto_subscribe(mosq, nullptr, topic.c_str(), 0);
+}
+
+static void mqtt_on_disconnect(struct mosquitto *mosq, void *obj, int rc)
+{
+    ESP_LOGW("NASA2MQTT", "MQTT disconnected");
+    mqtt_client_connected = false;
+    // QoS 0 messages still queued are discarded without a callback
+    mqtt_outbox_state.depth = 0;
+}
+
+static void mqtt_on_message(struct mosquitto *mosq, void *obj, const struct mosquitto_message *message)
+{
+    mqtt_inbox_push(message->topic, std::string((const char *)message->payload, message->payloadlen));
+}
+#endif
+
+#if defined(USE_ESP8266) || defined(USE_ESP32) || defined(USE_MOSQUITTO)
+static void mqtt_inbox_push(const std::string &topic, const std::string &payload)
+{
+#ifdef USE_ESP32
+    std::lock_guard<std::mutex> guard(mqtt_inbox_lock);
+#endif
+    if (mqtt_inbox.size() >= MQTT_INBOX_SIZE)
+    {
+        ESP_LOGW("NASA2MQTT", "MQTT inbox full, dropping message on %s", topic.c_str());
+        return;
+    }
+    mqtt_inbox.push_back({topic, payload, esphome::millis()});
+}
+
+static void mqtt_qos1_match(int msg_id, uint32_t at)
+{
+    for (auto it = mqtt_inflight.begin(); it != mqtt_inflight.end(); ++it)
+    {
+        if (it->msg_id == msg_id)
+        {
+            mqtt_qos1_state.puback_us.add(at - it->sent_at);
+            mqtt_qos1_state.acked++;
+            mqtt_inflight.erase(it);
+            return;
+        }
+    }
+    // a QoS 0 message (libmosquitto reports those as well) or a send that has been retransmitted since
+}
+
+static void mqtt_qos1_acked(int msg_id)
+{
+    const uint32_t at = esphome::micros();
+#ifdef USE_ESP32
+    std::lock_guard<std::mutex> guard(mqtt_acks_lock);
+    // holds more than a full window, a lost one only means a needless retransmit count
+    if (mqtt_acks.size() < MQTT_ACKS_SIZE)
+        mqtt_acks.emplace_back(msg_id, at);
+#else
+    // same thread as the main loop
+    mqtt_qos1_match(msg_id, at);
+#endif
+}
+#endif
 
 namespace esphome
 {
@@ -62,11 +291,31 @@ namespace esphome
                 return false;
 
             return is_mqtt_connected; // <-- Use the status variable
+#elif defined(USE_MOSQUITTO)
+            return mqtt_client_connected;
 #else
             return false;
 #endif
         }
 
+        void mqtt_set_tls(const std::string &ca)
+        {
+            mqtt_tls_ca = ca;
+        }
+
+        void mqtt_set_session(const std::string &client_id, bool clean_session)
+        {
+            mqtt_client_id = client_id;
+            mqtt_clean_session = clean_session;
+        }
+
+        void mqtt_set_inflight(uint8_t window, uint32_t retransmit_timeout)
+        {
+            mqtt_inflight_window = window;
+            mqtt_retransmit_timeout = retransmit_timeout;
+            mqtt_inflight.reserve(window);
+        }
+
 void mqtt_connect(const std::string &host, const uint16_t port, const std::string &username, const std::string &password)
         {
 #ifdef USE_ESP8266
@@ -76,10 +325,42 @@ void mqtt_connect(const std::string &host, const uint16_t port, const std::strin
                 mqtt_client->setServer(host.c_str(), port);
                 if (username.length() > 0)
                     mqtt_client->setCredentials(username.c_str(), password.c_str());
+                if (mqtt_client_id.length() > 0)
+                    mqtt_client->setClientId(mqtt_client_id.c_str());
+                mqtt_client->setCleanSession(mqtt_clean_session);
+                if (mqtt_tls_ca.length() > 0)
+                {
+#if ASYNC_TCP_SSL_ENABLED
+                    // axTLS cannot check a chain, the broker certificate is pinned instead
+                    uint8_t fingerprint[20] = {};
+                    for (size_t i = 0; i < sizeof(fingerprint) && 2 * i + 1 < mqtt_tls_ca.length(); i++)
+                        fingerprint[i] = strtoul(mqtt_tls_ca.substr(2 * i, 2).c_str(), nullptr, 16);
+                    mqtt_client->setSecure(true);
+                    mqtt_client->addServerFingerprint(fingerprint);
+#else
+                    ESP_LOGE("NASA2MQTT", "MQTT over TLS needs ASYNC_TCP_SSL_ENABLED");
+#endif
+                }
+                mqtt_client->onConnect([](bool sessionPresent)
+                                       {
+                                           mqtt_connect_done(MqttTlsResumption::None, sessionPresent);
+                                           for (auto const &topic : mqtt_subscriptions)
+                                               mqtt_client->subscribe(topic.c_str(), 0);
+                                       });
+                mqtt_client->onPublish([](uint16_t packetId)
+                                       { mqtt_qos1_acked(packetId); });
+                mqtt_client->onMessage([](char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total)
+                                       {
+                                           if (index == 0 && len == total)
+                                               mqtt_inbox_push(topic, std::string(payload, len));
+                                       });
             }
 
             if (!mqtt_client->connected())
+            {
+                mqtt_connect_started();
                 mqtt_client->connect();
+            }
 #elif USE_ESP32
             
             if (mqtt_client == nullptr)
@@ -93,6 +374,26 @@ void mqtt_connect(const std::string &host, const uint16_t port, const std::strin
                 mqtt_cfg.broker.address.port = port;      
                 mqtt_cfg.broker.address.transport = MQTT_TRANSPORT_OVER_TCP;
                 //mqtt_cfg.broker.address.uri = "mqtt://192.168.20.123:1883";
+                if (mqtt_tls_ca.length() > 0)
+                {
+                    mqtt_cfg.broker.address.transport = MQTT_TRANSPORT_OVER_SSL;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+                    // the client takes ownership and destroys it with itself
+                    mqtt_tls_transport = esp_transport_ssl_init();
+                    esp_transport_set_default_port(mqtt_tls_transport, port);
+                    esp_transport_ssl_set_cert_data(mqtt_tls_transport, mqtt_tls_ca.c_str(), mqtt_tls_ca.length());
+                    esp_transport_ssl_session_ticket_operation(mqtt_tls_transport, ESP_TRANSPORT_SESSION_TICKET_INIT);
+                    mqtt_cfg.network.transport = mqtt_tls_transport;
+#else
+                    mqtt_cfg.broker.verification.certificate = mqtt_tls_ca.c_str();
+#endif
+                }
+                if (mqtt_client_id.length() > 0)
+                    mqtt_cfg.credentials.client_id = mqtt_client_id.c_str();
+                mqtt_cfg.session.disable_clean_session = !mqtt_clean_session;
+                mqtt_cfg.outbox.limit = MQTT_OUTBOX_LIMIT;
+                // esp-mqtt resends unacknowledged QoS 1 messages from its outbox itself
+                mqtt_cfg.session.message_retransmit_timeout = mqtt_retransmit_timeout;
 
                 if (username.length() > 0)
                 {
@@ -107,25 +408,271 @@ void mqtt_connect(const std::string &host, const uint16_t port, const std::strin
                 esp_mqtt_client_register_event(mqtt_client, (esp_mqtt_event_id_t)ESP_EVENT_ANY_ID, (esp_event_handler_t)mqtt_event_handler, mqtt_client);                
                 esp_mqtt_client_start(mqtt_client);
             }
+#elif defined(USE_MOSQUITTO)
+            if (mqtt_client == nullptr)
+            {
+                mosquitto_lib_init();
+                mqtt_client = mosquitto_new(mqtt_client_id.empty() ? nullptr : mqtt_client_id.c_str(), mqtt_clean_session, nullptr);
+                if (username.length() > 0)
+                    mosquitto_username_pw_set(mqtt_client, username.c_str(), password.c_str());
+                if (mqtt_tls_ca.length() > 0)
+                {
+                    // libmosquitto sets the context up as usual, plus the session kept for reconnects
+                    mqtt_tls_context = tls_resuming_context();
+                    mosquitto_int_option(mqtt_client, MOSQ_OPT_SSL_CTX_WITH_DEFAULTS, 1);
+                    mosquitto_void_option(mqtt_client, MOSQ_OPT_SSL_CTX, mqtt_tls_context);
+                    mosquitto_tls_set(mqtt_client, mqtt_tls_ca.c_str(), nullptr, nullptr, nullptr, nullptr);
+                }
+                mosquitto_connect_with_flags_callback_set(mqtt_client, mqtt_on_connect);
+                mosquitto_disconnect_callback_set(mqtt_client, mqtt_on_disconnect);
+                mosquitto_publish_callback_set(mqtt_client, mqtt_on_publish);
+                mosquitto_message_callback_set(mqtt_client, mqtt_on_message);
+                mqtt_connect_started();
+                mosquitto_connect_async(mqtt_client, host.c_str(), port, 60);
+            }
+            else if (!mqtt_client_connected && mosquitto_socket(mqtt_client) == -1)
+            {
+                mqtt_connect_started();
+                mosquitto_reconnect_async(mqtt_client);
+            }
+#endif
+        }
+
+        // Depth as of now where the client can tell it
+        static void mqtt_update_outbox()
+        {
+#ifdef USE_ESP32
+            if (mqtt_client != nullptr)
+                mqtt_outbox_state.depth = esp_mqtt_client_get_outbox_size(mqtt_client);
 #endif
+            if (mqtt_outbox_state.depth > mqtt_outbox_state.peak)
+                mqtt_outbox_state.peak = mqtt_outbox_state.depth;
         }
 
-        bool mqtt_publish(const std::string &topic, const std::string &payload)
+        // msg_id of the message handed to the client (0 or meaningless for QoS 0), -1 when it was refused
+        static int mqtt_client_publish(const std::string &topic, const std::string &payload, uint8_t qos, bool retain)
         {
 #ifdef USE_ESP8266
             if (mqtt_client == nullptr)
-                return false;
-
-            return mqtt_client->publish(topic.c_str(), 0, false, payload.c_str()) != 0;
+                return -1;
+            // the packet id, 0 when the TCP send buffer is full
+            uint16_t id = mqtt_client->publish(topic.c_str(), qos, retain, payload.c_str(), payload.length());
+            return id == 0 ? -1 : id;
 #elif USE_ESP32
             if (mqtt_client == nullptr)
+                return -1;
+            // enqueue leaves sending to the MQTT task, where publish would write to the socket right here
+            int id = esp_mqtt_client_enqueue(mqtt_client, topic.c_str(), payload.c_str(), payload.length(), qos, retain, true);
+            return id < 0 ? -1 : id;
+#elif defined(USE_MOSQUITTO)
+            int mid = 0;
+            if (mqtt_client == nullptr || mqtt_outbox_state.depth >= MQTT_OUTBOX_LIMIT ||
+                mosquitto_publish(mqtt_client, &mid, topic.c_str(), payload.length(), payload.c_str(), qos, retain) != MOSQ_ERR_SUCCESS)
+                return -1;
+            mqtt_outbox_state.depth++;
+            return mid;
+#else
+            return 0;
+#endif
+        }
+
+        // Moves queued QoS 1 messages into the window while there is room
+        static void mqtt_qos1_send_queued()
+        {
+            while (!mqtt_qos1_queue.empty() && mqtt_inflight.size() < mqtt_inflight_window && mqtt_connected())
+            {
+                MqttQos1Message &message = mqtt_qos1_queue.front();
+                message.sent_at = micros();
+                message.msg_id = mqtt_client_publish(message.topic, message.payload, 1, message.retain);
+                if (message.msg_id < 0)
+                    return; // the next loop tries again
+                mqtt_inflight.push_back(std::move(message));
+                mqtt_qos1_queue.pop_front();
+            }
+        }
+
+        bool mqtt_publish(const std::string &topic, const std::string &payload, uint8_t qos, bool retain)
+        {
+            // a full QoS 1 queue means PUBACKs are slow, the outbox may well have room: not a refusal
+            if (qos == 1 && mqtt_qos1_queue.size() >= MQTT_QOS1_QUEUE_SIZE)
                 return false;
 
-            return esp_mqtt_client_publish(mqtt_client, topic.c_str(), payload.c_str(), payload.length(), 0, false) != -1;
-#else
-            return true;
+            const uint32_t started = micros();
+            bool queued = true;
+            if (qos == 1)
+            {
+                mqtt_qos1_queue.push_back({topic, payload, retain, -1, 0});
+                mqtt_qos1_send_queued();
+            }
+            else
+                queued = mqtt_client_publish(topic, payload, qos, retain) >= 0;
+            mqtt_outbox_state.enqueue_us.add(micros() - started);
+            if (!queued)
+            {
+                mqtt_outbox_state.refused++;
+                mqtt_refused_at = millis();
+                mqtt_refused_recently = true;
+            }
+            mqtt_update_outbox();
+            return queued;
+        }
+
+        void mqtt_loop()
+        {
+#ifdef USE_ESP32
+            {
+                std::lock_guard<std::mutex> guard(mqtt_acks_lock);
+                for (auto &ack : mqtt_acks)
+                    mqtt_qos1_match(ack.first, ack.second);
+                mqtt_acks.clear();
+            }
 #endif
-         
+            if (!mqtt_connected())
+            {
+                mqtt_qos1_connected = false;
+                return;
+            }
+            // timers restart on a reconnect, the client resends what was in flight
+            const bool reconnected = !mqtt_qos1_connected;
+            mqtt_qos1_connected = true;
+            const uint32_t now = micros();
+            for (auto &message : mqtt_inflight)
+            {
+                if (reconnected)
+                {
+                    message.sent_at = now;
+#ifdef USE_ESP8266
+                    // AsyncMqttClient keeps nothing across a disconnect
+                    message.msg_id = mqtt_client_publish(message.topic, message.payload, 1, message.retain);
+#endif
+                    continue;
+                }
+#ifdef USE_MOSQUITTO
+                // libmosquitto keeps the message under its mid and resends it on a reconnect; sent again
+                // from here it would go out twice, the PUBACK of the original matching nothing
+                continue;
+#endif
+                if (now - message.sent_at < mqtt_retransmit_timeout * 1000)
+                    continue;
+                message.sent_at = now;
+#ifdef USE_ESP8266
+                // refused by the client, so never sent: trying again makes no duplicate
+                if (message.msg_id < 0)
+                {
+                    message.msg_id = mqtt_client_publish(message.topic, message.payload, 1, message.retain);
+                    continue;
+                }
+                // MQTT 3.1.1 resends only after a reconnect; a copy under a new packet id would reach
+                // subscribers twice, so the timeout is only counted
+#endif
+                // on the ESP32 esp-mqtt has resent it from its outbox after the same timeout
+                mqtt_qos1_state.retransmitted++;
+                ESP_LOGD("NASA2MQTT", "No PUBACK for %s after %u ms", message.topic.c_str(), (unsigned)mqtt_retransmit_timeout);
+            }
+            mqtt_qos1_send_queued();
+        }
+
+        const MqttOutbox &mqtt_outbox()
+        {
+#if defined(USE_ESP32) || defined(USE_MOSQUITTO)
+            mqtt_outbox_state.limit = MQTT_OUTBOX_LIMIT;
+#endif
+            return mqtt_outbox_state;
+        }
+
+        const MqttQos1 &mqtt_qos1()
+        {
+            mqtt_qos1_state.window = mqtt_inflight_window;
+            mqtt_qos1_state.inflight = mqtt_inflight.size();
+            mqtt_qos1_state.queued = mqtt_qos1_queue.size();
+            return mqtt_qos1_state;
+        }
+
+        bool mqtt_congested()
+        {
+            const MqttOutbox &outbox = mqtt_outbox();
+            if (outbox.limit > 0)
+            {
+                mqtt_update_outbox();
+                if (outbox.depth >= outbox.limit / 4 * 3)
+                    return true;
+            }
+            if (mqtt_refused_recently && millis() - mqtt_refused_at >= MQTT_REFUSED_BACKOFF_MS)
+                mqtt_refused_recently = false;
+            return mqtt_refused_recently;
         }
+
+        void mqtt_subscribe(const std::string &topic)
+        {
+            mqtt_subscriptions.push_back(topic);
+        }
+
+        bool mqtt_receive(const std::string &prefix, MqttMessage &message)
+        {
+#ifdef USE_ESP32
+            std::lock_guard<std::mutex> guard(mqtt_inbox_lock);
+#endif
+            for (auto it = mqtt_inbox.begin(); it != mqtt_inbox.end(); ++it)
+            {
+                if (it->topic.rfind(prefix, 0) == 0)
+                {
+                    message = std::move(*it);
+                    mqtt_inbox.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::string mqtt_stats_to_json()
+        {
+            const auto &stats = mqtt_connect_stats;
+            MqttOutbox outbox = mqtt_outbox();
+            MqttQos1 qos1 = mqtt_qos1();
+            const uint32_t full = stats.connects - stats.resumed - stats.offered;
+            return "{\"connects\":" + std::to_string(stats.connects) +
+                   ",\"resumed\":" + std::to_string(stats.resumed) +
+                   ",\"offered\":" + std::to_string(stats.offered) +
+                   ",\"session_present\":" + (stats.session_present ? "true" : "false") +
+                   ",\"last_ms\":" + std::to_string(stats.last_ms) +
+                   ",\"full_avg_ms\":" + std::to_string(full > 0 ? stats.full_ms / full : 0) +
+                   ",\"resumed_avg_ms\":" + std::to_string(stats.resumed > 0 ? stats.resumed_ms / stats.resumed : 0) +
+                   ",\"offered_avg_ms\":" + std::to_string(stats.offered > 0 ? stats.offered_ms / stats.offered : 0) +
+                   ",\"outbox\":" + std::to_string(outbox.depth) +
+                   ",\"outbox_peak\":" + std::to_string(outbox.peak) +
+                   ",\"outbox_limit\":" + std::to_string(outbox.limit) +
+                   ",\"refused\":" + std::to_string(outbox.refused) +
+                   ",\"enqueue_us\":" + outbox.enqueue_us.to_json() +
+                   ",\"qos1_window\":" + std::to_string(qos1.window) +
+                   ",\"inflight\":" + std::to_string(qos1.inflight) +
+                   ",\"qos1_queued\":" + std::to_string(qos1.queued) +
+                   ",\"acked\":" + std::to_string(qos1.acked) +
+                   ",\"retransmitted\":" + std::to_string(qos1.retransmitted) +
+                   ",\"puback_us\":" + qos1.puback_us.to_json() + "}";
+        }
+
+#ifdef USE_MOSQUITTO
+        int mqtt_socket()
+        {
+            return mqtt_client == nullptr ? -1 : mosquitto_socket(mqtt_client);
+        }
+
+        bool mqtt_want_write()
+        {
+            return mqtt_client != nullptr && mosquitto_want_write(mqtt_client);
+        }
+
+        void mqtt_handle_io(bool readable, bool writable)
+        {
+            if (mqtt_client == nullptr)
+                return;
+
+            if (readable)
+                mosquitto_loop_read(mqtt_client, 1);
+            if (writable)
+                mosquitto_loop_write(mqtt_client, 1);
+            mosquitto_loop_misc(mqtt_client);
+        }
+#endif
     } // namespace nasa2mqtt
 } // namespace esphome
@@ -1,15 +1,81 @@
 #pragma once
 #include <iostream>
+#include <vector>
+#include "util.h"
 
 namespace esphome
 {
     namespace nasa2mqtt
     {
         bool mqtt_connected();
+        // TLS and session settings take effect when the client is created by the first mqtt_connect;
+        // all buses share that client.
+        // ca is the CA certificate (PEM) on the ESP32, the SHA-1 fingerprint of the broker certificate
+        // (hex) on the ESP8266 and a CA file for the daemon; empty is plain TCP
+        void mqtt_set_tls(const std::string &ca);
+        // With a fixed client id and clean_session off the broker keeps subscriptions and QoS 1
+        // messages across reconnects
+        void mqtt_set_session(const std::string &client_id, bool clean_session);
+        // QoS 1 publishes are pipelined: up to window of them wait for their PUBACK at once, further ones
+        // queue here and follow as acknowledgements come in. One without a PUBACK after retransmit_timeout
+        // ms counts as retransmitted and esp-mqtt sends it again; AsyncMqttClient and libmosquitto
+        // resend only on a reconnect, as MQTT 3.1.1 has it.
+        void mqtt_set_inflight(uint8_t window, uint32_t retransmit_timeout);
         void mqtt_connect(const std::string &host, const uint16_t port, const std::string &username, const std::string &password);
-        bool mqtt_publish(const std::string &topic, const std::string &payload);
+        // Hands the message to the client's outbox without waiting for the network; false when it was
+        // refused (not connected, outbox full, QoS 1 queue full), the caller decides what to do with it
+        bool mqtt_publish(const std::string &topic, const std::string &payload, uint8_t qos = 0, bool retain = false);
+        // Sends queued QoS 1 messages as the window allows and retransmits overdue ones, from the main loop
+        void mqtt_loop();
+
+        struct MqttOutbox
+        {
+            // bytes on the ESP32, messages for the daemon; the ESP8266 client does not tell (limit 0)
+            uint32_t depth = 0;
+            uint32_t peak = 0;
+            uint32_t limit = 0;
+            uint32_t refused = 0;
+            LatencyStats enqueue_us; // time mqtt_publish takes, since boot
+        };
+        const MqttOutbox &mqtt_outbox();
+
+        struct MqttQos1
+        {
+            uint8_t window = 0;
+            uint32_t inflight = 0; // sent, waiting for the PUBACK
+            uint32_t queued = 0;   // waiting for a slot in the window
+            uint32_t acked = 0;
+            uint32_t retransmitted = 0;
+            LatencyStats puback_us; // last send to PUBACK, since boot
+        };
+        const MqttQos1 &mqtt_qos1();
+        // True while the outbox is three quarters full, or shortly after a refused publish where its
+        // depth is unknown. Publishers hold back and coalesce what can wait while it lasts.
+        bool mqtt_congested();
+
+        struct MqttMessage
+        {
+            std::string topic;
+            std::string payload;
+            uint32_t received; // millis()
+        };
+
+        // Subscriptions are (re)applied on every connect
+        void mqtt_subscribe(const std::string &topic);
+        // Messages arrive on the network task and are handed out here from the main loop,
+        // to the bus whose topic prefix they start with
+        bool mqtt_receive(const std::string &prefix, MqttMessage &message);
+        // Connects so far, how many resumed the TLS session or offered one without knowing the outcome
+        // (ESP32), how long connects took (ms), outbox and QoS 1 window
+        std::string mqtt_stats_to_json();
 #ifdef USE_ESP32
         extern volatile bool is_mqtt_connected;
+#endif
+#ifdef USE_MOSQUITTO
+        // The Linux daemon polls the broker socket in its own event loop
+        int mqtt_socket();
+        bool mqtt_want_write();
+        void mqtt_handle_io(bool readable, bool writable);
 #endif
     } // namespace nasa2mqtt
 } // namespace esphome
@@ -2,9 +2,15 @@
 #include <iostream>
 #include "esphome/core/log.h"
 #include "esphome/core/util.h"
+#include "esphome/core/hal.h"
 #include "util.h"
 #include "nasa.h"
 #include "mqtt.h"
+#include "catalog.h"
+#include "publisher.h"
+#include "structure.h"
+#include "sequence.h"
+#include "dedup.h"
 
 static const char *TAG = "NASA2MQTT";
 
@@ -57,6 +63,13 @@ namespace esphome
             address = data[index + 2];
         }
 
+        void Address::encode(std::vector<uint8_t> &data)
+        {
+            data.push_back((uint8_t)aclass);
+            data.push_back(channel);
+            data.push_back(address);
+        }
+
         std::string Address::to_string()
         {
             char str[9];
@@ -74,6 +87,13 @@ namespace esphome
             packetNumber = data[index + 2];
         }
 
+        void Command::encode(std::vector<uint8_t> &data)
+        {
+            data.push_back((uint8_t)((packetInformation ? 128 : 0) | ((int)protocolVersion << 5 & 96) | ((int)retryCount << 3 & 24)));
+            data.push_back((uint8_t)(((int)packetType << 4 & 240) | ((int)dataType & 15)));
+            data.push_back(packetNumber);
+        }
+
         std::string Command::to_string()
         {
             std::string str;
@@ -88,45 +108,73 @@ namespace esphome
             return str;
         }
 
-        MessageSet MessageSet::decode(std::vector<uint8_t> &data, unsigned int index, int capacity)
+        uint16_t MessageSet::encoded_size(const uint8_t *data, uint16_t available, int capacity)
+        {
+            if (available < 2)
+                return 0;
+            switch ((MessageSetType)((data[0] >> 1) & 3))
+            {
+            case Enum:
+                return available >= 3 ? 3 : 0;
+            case Variable:
+                return available >= 4 ? 4 : 0;
+            case LongVariable:
+                return available >= 6 ? 6 : 0;
+            default:
+                // travels alone and runs up to the crc
+                return capacity == 1 ? available : 0;
+            }
+        }
+
+        MessageSet MessageSet::decode(const uint8_t *data, uint16_t size)
         {
-            MessageSet set = MessageSet((MessageNumber)((uint32_t)data[index] * 256U + (uint32_t)data[index + 1]));
+            MessageSet set = MessageSet((MessageNumber)((uint32_t)data[0] * 256U + (uint32_t)data[1]));
+            set.size = size;
             switch (set.type)
             {
             case Enum:
-                set.value = (int)data[index + 2];
-                set.size = 3;
+                set.value = (int)data[2];
                 break;
             case Variable:
-                set.value = (int)data[index + 2] << 8 | (int)data[index + 3];
-                set.size = 4;
+                set.value = (int)data[2] << 8 | (int)data[3];
                 break;
             case LongVariable:
-                set.value = (int)data[index + 2] << 24 | (int)data[index + 3] << 16 | (int)data[index + 4] << 8 | (int)data[index + 5];
-                set.size = 6;
+                set.value = (int)data[2] << 24 | (int)data[3] << 16 | (int)data[4] << 8 | (int)data[5];
                 break;
+            default:
+                set.structure = {data + 2, (uint16_t)(size - 2)};
+                break;
+            }
+            return set;
+        }
 
+        void MessageSet::encode(std::vector<uint8_t> &data)
+        {
+            data.push_back((uint8_t)((uint16_t)messageNumber >> 8));
+            data.push_back((uint8_t)((uint16_t)messageNumber & 0xFF));
+            switch (type)
+            {
+            case Enum:
+                data.push_back((uint8_t)value);
+                break;
+            case Variable:
+                data.push_back((uint8_t)(value >> 8));
+                data.push_back((uint8_t)value);
+                break;
+            case LongVariable:
+                data.push_back((uint8_t)(value >> 24));
+                data.push_back((uint8_t)(value >> 16));
+                data.push_back((uint8_t)(value >> 8));
+                data.push_back((uint8_t)value);
+                break;
             case Structure:
-                if (capacity != 1)
+                for (int i = 0; i < structure.size; i++)
                 {
-                    ESP_LOGE(TAG, "structure messages can only have one message but is %d", capacity);
-                    return set;
+                    data.push_back(structure.data[i]);
                 }
-                Buffer buffer;
-                set.size = data.size() - index - 3; // 3=end bytes
-                buffer.size = set.size - 2;
-                for (int i = 0; i < buffer.size; i++)
-                {
-                    buffer.data[i] = data[i];
-                }
-                set.structure = buffer;
                 break;
-            default:
-                ESP_LOGE(TAG, "Unkown type");
             }
-
-            return set;
-        };
+        }
 
         std::string MessageSet::to_string()
         {
@@ -139,15 +187,57 @@ namespace esphome
             case LongVariable:
                 return "LongVariable " + long_to_hex((uint16_t)messageNumber) + " " + std::to_string(value);
             case Structure:
-                return "Structure #" + long_to_hex((uint16_t)messageNumber) + " " + std::to_string(structure.size);
+                return "Structure #" + long_to_hex((uint16_t)messageNumber) + " " + structure_to_payload(messageNumber, structure);
             default:
                 return "Unknown";
             }
         }
 
-        static int _packetCounter = 0;
+        Packet Packet::create(Address da, DataType dataType, uint8_t &packetNumber)
+        {
+            Packet packet;
+            packet.sa = Address::get_my_address();
+            packet.da = da;
+            packet.pcommand.packetInformation = true;
+            packet.pcommand.packetType = PacketType::Normal;
+            packet.pcommand.dataType = dataType;
+            packet.pcommand.packetNumber = packetNumber++;
+            return packet;
+        }
+
+        std::vector<uint8_t> Packet::encode()
+        {
+            std::vector<uint8_t> data;
+            data.push_back(0x32);
+            data.push_back(0); // size, filled in below
+            data.push_back(0);
+
+            sa.encode(data);
+            da.encode(data);
+            pcommand.encode(data);
+
+            data.push_back((uint8_t)messages.size());
+            for (auto &message : messages)
+                message.encode(data);
+
+            // size counts everything after the start byte and the size itself, including crc and end byte
+            int size = data.size() + 1;
+            data[1] = (uint8_t)(size >> 8);
+            data[2] = (uint8_t)(size & 0xFF);
+
+            uint16_t crc = crc16(data, 3, size - 4);
+            data.push_back((uint8_t)(crc >> 8));
+            data.push_back((uint8_t)(crc & 0xFF));
+            data.push_back(0x34);
+            return data;
+        }
 
         bool Packet::decode(std::vector<uint8_t> &data)
+        {
+            return decode_header(data) && decode_messages(data);
+        }
+
+        bool Packet::decode_header(std::vector<uint8_t> &data)
         {
             if (data[0] != 0x32)
             {
@@ -192,21 +282,40 @@ namespace esphome
             cursor += da.size;
 
             pcommand.decode(data, cursor);
-            cursor += pcommand.size;
+            return true;
+        }
 
-            int capacity = (int)data[cursor];
+        bool Packet::decode_messages(std::vector<uint8_t> &data)
+        {
+            unsigned int cursor = 3 + sa.size + da.size + pcommand.size;
+            const int capacity = (int)data[cursor];
             cursor++;
+            // message sets end where crc and end byte begin, decode_header made sure that is past the cursor
+            const unsigned int end = data.size() - 3;
+
+            // the whole layout first, so the decode below reads without further checks
+            unsigned int next = cursor;
+            for (int i = 0; i < capacity; i++)
+            {
+                uint16_t size = MessageSet::encoded_size(data.data() + next, end - next, capacity);
+                if (size == 0)
+                {
+                    ESP_LOGW(TAG, "malformed message set %d of %d at offset %u, dropping the frame", i + 1, capacity, next);
+                    messages.clear();
+                    return false;
+                }
+                next += size;
+            }
 
             messages.clear();
-            for (int i = 1; i <= capacity; ++i)
+            for (int i = 0; i < capacity; i++)
             {
-                MessageSet set = MessageSet::decode(data, cursor, capacity);
+                MessageSet set = MessageSet::decode(data.data() + cursor, MessageSet::encoded_size(data.data() + cursor, end - cursor, capacity));
                 messages.push_back(set);
                 cursor += set.size;
             }
-
             return true;
-        };
+        }
 
         std::string Packet::to_string()
         {
@@ -224,18 +333,40 @@ namespace esphome
             return str;
         }
 
-        Packet packet_;
-
-        void process_nasa_message(std::vector<uint8_t> data, MessageTarget *target)
+        void process_nasa_message(std::vector<uint8_t> &data, MessageTarget *target)
         {
-            if (packet_.decode(data) == false)
+            const uint32_t decoded_at = micros();
+
+            Packet &packet_ = target->packet();
+            if (packet_.decode_header(data) == false)
+                return;
+
+            // our own requests echoed back by the RS485 transceiver
+            if (packet_.sa == Address::get_my_address())
+                return;
+
+            // retransmissions are dropped before their messages are even looked at
+            if (!target->sequence_tracker().accept(packet_.sa, packet_.pcommand, millis()))
+            {
+                ESP_LOGV(TAG, "Dropped retransmission from %s, packet %d", packet_.sa.to_string().c_str(), packet_.pcommand.packetNumber);
+                return;
+            }
+
+            // a notification repeating the last one of its kind has no news for anything downstream
+            const bool deduped = packet_.pcommand.dataType == DataType::Notification && target->frame_dedup().enabled();
+            if (deduped && target->frame_dedup().repeated(data, packet_, millis()))
                 return;
 
-            if (debug_log_messages)
+            if (!packet_.decode_messages(data))
+                return;
+
+            if (target->debug_log_messages)
             {
                 ESP_LOGW(TAG, "MSG: %s", packet_.to_string().c_str());
             }
 
+            target->handle_packet(packet_);
+
             if (packet_.pcommand.dataType == DataType::Request)
             {
                 ESP_LOGW(TAG, "Request %s", packet_.to_string().c_str());
@@ -256,315 +387,45 @@ namespace esphome
             for (int i = 0; i < packet_.messages.size(); i++)
             {
                 MessageSet &message = packet_.messages[i];
-                if (debug_log_messages)
+                if (target->debug_log_messages)
                 {
                     if (mqtt_connected())
                     {
                         if (message.type == MessageSetType::Enum)
                         {
-                            mqtt_publish("samsung_ehs_debug/nasa/enum/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
+                            mqtt_publish(target->publisher().topic_prefix + "_debug/nasa/enum/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
                         }
                         else if (message.type == MessageSetType::Variable)
                         {
-                            mqtt_publish("samsung_ehs_debug/nasa/var/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
+                            mqtt_publish(target->publisher().topic_prefix + "_debug/nasa/var/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
                         }
                         else if (message.type == MessageSetType::LongVariable)
                         {
-                            mqtt_publish("samsung_ehs_debug/nasa/var_long/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
+                            mqtt_publish(target->publisher().topic_prefix + "_debug/nasa/var_long/" + long_to_hex((uint16_t)message.messageNumber), std::to_string(message.value));
+                        }
+                        else if (message.type == MessageSetType::Structure)
+                        {
+                            mqtt_publish(target->publisher().topic_prefix + "_debug/nasa/struct/" + long_to_hex((uint16_t)message.messageNumber), structure_to_payload(message.messageNumber, message.structure));
                         }
                     }
                 }
 
-				// send relevant EHS messages via MQTT
-               	switch (message.messageNumber)
-				{		
-					case MessageNumber::VAR_AD_ERROR_CODE1_202:
-					case MessageNumber::VAR_AD_INSTALL_NUMBER_INDOOR_207:
-					case MessageNumber::ENUM_NM_2004:
-					case MessageNumber::ENUM_NM_2012:
-					case MessageNumber::VAR_NM_22F7:
-					case MessageNumber::VAR_NM_22F9:
-					case MessageNumber::VAR_NM_22FA:
-					case MessageNumber::VAR_NM_22FB:
-					case MessageNumber::VAR_NM_22FC:
-					case MessageNumber::VAR_NM_22FD:
-					case MessageNumber::VAR_NM_22FE:
-					case MessageNumber::VAR_NM_22FF:
-					case MessageNumber::LVAR_NM_2400:
-					case MessageNumber::LVAR_NM_2401:
-					case MessageNumber::LVAR_NM_24FB:
-					case MessageNumber::LVAR_NM_24FC:
-					case MessageNumber::LVAR_AD_ADDRESS_RMC_402:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_ALL_409:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_POWER_40A:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_MODE_40B:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_FAN_MODE_40C:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_FAN_DIRECTION_40D:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_TEMP_TARGET_40E:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_OPERATION_MODE_ONLY_410:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_COOL_MODE_UPPER_411:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_COOL_MODE_LOWER_412:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_HEAT_MODE_UPPER_413:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_HEAT_MODE_LOWER_414:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_CONTACT_CONTROL_415:
-					case MessageNumber::LVAR_AD_INSTALL_LEVEL_KEY_OPERATION_INPUT_416:
-					case MessageNumber::LVAR_AD_417:
-					case MessageNumber::LVAR_AD_418:
-					case MessageNumber::LVAR_AD_419:
-					case MessageNumber::LVAR_AD_41B:
-					case MessageNumber::ENUM_IN_OPERATION_POWER_4000:
-					case MessageNumber::ENUM_IN_OPERATION_MODE_4001:
-					case MessageNumber::ENUM_IN_OPERATION_MODE_REAL_4002:
-					case MessageNumber::ENUM_IN_FAN_MODE_4006:
-					case MessageNumber::ENUM_IN_FAN_MODE_REAL_4007:
-					case MessageNumber::ENUM_IN_400F:
-					case MessageNumber::ENUM_IN_4010:
-					case MessageNumber::ENUM_IN_4015:
-					case MessageNumber::ENUM_IN_4019:
-					case MessageNumber::ENUM_IN_401B:
-					case MessageNumber::ENUM_IN_4023:
-					case MessageNumber::ENUM_IN_4024:
-					case MessageNumber::ENUM_IN_4027:
-					case MessageNumber::ENUM_IN_STATE_THERMO_4028:
-					case MessageNumber::ENUM_IN_4029:
-					case MessageNumber::ENUM_IN_402A:
-					case MessageNumber::ENUM_IN_402B:
-					case MessageNumber::ENUM_IN_402D:
-					case MessageNumber::ENUM_IN_STATE_DEFROST_MODE_402E:
-					case MessageNumber::ENUM_IN_4031:
-					case MessageNumber::ENUM_IN_4035:
-					case MessageNumber::ENUM_IN_STATE_HUMIDITY_PERCENT_4038:
-					case MessageNumber::ENUM_IN_4043:
-					case MessageNumber::ENUM_IN_SILENCE_4046:
-					case MessageNumber::ENUM_IN_4047:
-					case MessageNumber::ENUM_IN_4048:
-					case MessageNumber::ENUM_IN_404F:
-					case MessageNumber::ENUM_IN_4051:
-					case MessageNumber::ENUM_IN_4059:
-					case MessageNumber::ENUM_IN_405F:
-					case MessageNumber::ENUM_IN_ALTERNATIVE_MODE_4060:
-					case MessageNumber::ENUM_IN_WATER_HEATER_POWER_4065:
-					case MessageNumber::ENUM_IN_WATER_HEATER_MODE_4066:
-					case MessageNumber::ENUM_IN_3WAY_VALVE_4067:
-					case MessageNumber::ENUM_IN_SOLAR_PUMP_4068:
-					case MessageNumber::ENUM_IN_THERMOSTAT1_4069:
-					case MessageNumber::ENUM_IN_THERMOSTAT2_406A:
-					case MessageNumber::ENUM_IN_406B:
-					case MessageNumber::ENUM_IN_BACKUP_HEATER_406C:
-					case MessageNumber::ENUM_IN_OUTING_MODE_406D:
-					case MessageNumber::ENUM_IN_REFERENCE_EHS_TEMP_406F:
-					case MessageNumber::ENUM_IN_DISCHAGE_TEMP_CONTROL_4070:
-					case MessageNumber::ENUM_IN_4073:
-					case MessageNumber::ENUM_IN_4074:
-					case MessageNumber::ENUM_IN_4077:
-					case MessageNumber::ENUM_IN_407B:
-					case MessageNumber::ENUM_IN_407D:
-					case MessageNumber::ENUM_IN_LOUVER_LR_SWING_407E:
-					case MessageNumber::ENUM_IN_4085:
-					case MessageNumber::ENUM_IN_4086:
-					case MessageNumber::ENUM_IN_BOOSTER_HEATER_4087:
-					case MessageNumber::ENUM_IN_STATE_WATER_PUMP_4089:
-					case MessageNumber::ENUM_IN_2WAY_VALVE_408A:
-					case MessageNumber::ENUM_IN_FSV_2091_4095:
-					case MessageNumber::ENUM_IN_FSV_2092_4096:
-					case MessageNumber::ENUM_IN_FSV_3011_4097:
-					case MessageNumber::ENUM_IN_FSV_3041_4099:
-					case MessageNumber::ENUM_IN_FSV_3042_409A:
-					case MessageNumber::ENUM_IN_FSV_3061_409C:
-					case MessageNumber::ENUM_IN_FSV_5061_40B4:
-					case MessageNumber::ENUM_IN_40B5:
-					case MessageNumber::ENUM_IN_WATERPUMP_PWM_VALUE_40C4:
-					case MessageNumber::ENUM_IN_THERMOSTAT_WATER_HEATER_40C5:
-					case MessageNumber::ENUM_IN_40C6:
-					case MessageNumber::ENUM_IN_4117:
-					case MessageNumber::ENUM_IN_FSV_4061_411A:
-					case MessageNumber::ENUM_IN_OPERATION_POWER_ZONE2_411E:
-					case MessageNumber::ENUM_IN_SG_READY_MODE_STATE_4124:
-					case MessageNumber::ENUM_IN_FSV_LOAD_SAVE_4125:
-					case MessageNumber::ENUM_IN_FSV_2093_4127:
-					case MessageNumber::ENUM_IN_FSV_5022_4128:
-					case MessageNumber::VAR_IN_TEMP_TARGET_F_4201:
-					case MessageNumber::VAR_IN_TEMP_4202:
-					case MessageNumber::VAR_IN_TEMP_ROOM_F_4203: 
-					case MessageNumber::VAR_IN_TEMP_4204:
-					case MessageNumber::VAR_IN_TEMP_EVA_IN_F_4205:
-					case MessageNumber::VAR_IN_TEMP_EVA_OUT_F_4206:
-					case MessageNumber::VAR_IN_TEMP_420C:
-					case MessageNumber::VAR_IN_CAPACITY_REQUEST_4211:
-					case MessageNumber::VAR_IN_CAPACITY_ABSOLUTE_4212:
-					case MessageNumber::VAR_IN_4213:
-					case MessageNumber::VAR_IN_EEV_VALUE_REAL_1_4217:
-					case MessageNumber::VAR_IN_MODEL_INFORMATION_4229:
-					case MessageNumber::VAR_IN_TEMP_WATER_HEATER_TARGET_F_4235:
-					case MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236:
-					case MessageNumber::VAR_IN_TEMP_WATER_TANK_F_4237:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUT_F_4238:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUT2_F_4239:
-					case MessageNumber::VAR_IN_423E:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_F_4247:
-					case MessageNumber::VAR_IN_TEMP_WATER_LAW_TARGET_F_4248:
-					case MessageNumber::VAR_IN_FSV_1011_424A:
-					case MessageNumber::VAR_IN_FSV_1012_424B:
-					case MessageNumber::VAR_IN_FSV_1021_424C:
-					case MessageNumber::VAR_IN_FSV_1022_424D:
-					case MessageNumber::VAR_IN_FSV_1031_424E:
-					case MessageNumber::VAR_IN_FSV_1032_424F:
-					case MessageNumber::VAR_IN_FSV_1041_4250:
-					case MessageNumber::VAR_IN_FSV_1042_4251:
-					case MessageNumber::VAR_IN_FSV_1051_4252:
-					case MessageNumber::VAR_IN_FSV_1052_4253:
-					case MessageNumber::VAR_IN_FSV_3043_4269:
-					case MessageNumber::VAR_IN_FSV_3044_426A:
-					case MessageNumber::VAR_IN_FSV_3045_426B:
-					case MessageNumber::VAR_IN_FSV_5011_4273:
-					case MessageNumber::VAR_IN_FSV_5012_4274:
-					case MessageNumber::VAR_IN_FSV_5013_4275:
-					case MessageNumber::VAR_IN_FSV_5014_4276:
-					case MessageNumber::VAR_IN_FSV_5015_4277:
-					case MessageNumber::VAR_IN_FSV_5016_4278:
-					case MessageNumber::VAR_IN_FSV_5017_4279:
-					case MessageNumber::VAR_IN_FSV_5018_427A:
-					case MessageNumber::VAR_IN_FSV_5019_427B:
-					case MessageNumber::VAR_IN_TEMP_WATER_LAW_F_427F:
-					case MessageNumber::VAR_IN_TEMP_MIXING_VALVE_F_428C:
-					case MessageNumber::VAR_IN_428D:
-					case MessageNumber::VAR_IN_FSV_3046_42CE:
-					case MessageNumber::VAR_IN_TEMP_ZONE2_F_42D4:
-					case MessageNumber::VAR_IN_TEMP_TARGET_ZONE2_F_42D6:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUTLET_TARGET_ZONE2_F_42D7:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE1_F_42D8:
-					case MessageNumber::VAR_IN_TEMP_WATER_OUTLET_ZONE2_F_42D9:
-					case MessageNumber::VAR_IN_FLOW_SENSOR_VOLTAGE_42E8:
-					case MessageNumber::VAR_IN_FLOW_SENSOR_CALC_42E9:
-					case MessageNumber::VAR_IN_42F1:
-					case MessageNumber::VAR_IN_4301:
-					case MessageNumber::LVAR_IN_4401:
-					case MessageNumber::LVAR_IN_DEVICE_STAUS_HEATPUMP_BOILER_440A:
-					case MessageNumber::LVAR_IN_440E:
-					case MessageNumber::LVAR_IN_440F:
-					case MessageNumber::LVAR_IN_4423:
-					case MessageNumber::LVAR_IN_4424:
-					case MessageNumber::LVAR_IN_4426:
-					case MessageNumber::LVAR_IN_4427:
-					case MessageNumber::ENUM_OUT_OPERATION_SERVICE_OP_8000:
-					case MessageNumber::ENUM_OUT_OPERATION_ODU_MODE_8001:
-					case MessageNumber::ENUM_OUT_8002:
-					case MessageNumber::ENUM_OUT_OPERATION_HEATCOOL_8003:
-					case MessageNumber::ENUM_OUT_8005:
-					case MessageNumber::ENUM_OUT_800D:
-					case MessageNumber::ENUM_OUT_LOAD_COMP1_8010:
-					case MessageNumber::ENUM_OUT_LOAD_HOTGAS_8017:
-					case MessageNumber::ENUM_OUT_LOAD_4WAY_801A:
-					case MessageNumber::ENUM_OUT_LOAD_OUTEEV_8020:
-					case MessageNumber::ENUM_OUT_8031:
-					case MessageNumber::ENUM_OUT_8032:
-					case MessageNumber::ENUM_OUT_8033:
-					case MessageNumber::ENUM_OUT_803F:
-					case MessageNumber::ENUM_OUT_8043:
-					case MessageNumber::ENUM_OUT_8045:
-					case MessageNumber::ENUM_OUT_OP_TEST_OP_COMPLETE_8046:
-					case MessageNumber::ENUM_OUT_8047:
-					case MessageNumber::ENUM_OUT_8048:
-					case MessageNumber::ENUM_OUT_805E:
-					case MessageNumber::ENUM_OUT_DEICE_STEP_INDOOR_8061:
-					case MessageNumber::ENUM_OUT_8066:
-					case MessageNumber::ENUM_OUT_8077:
-					case MessageNumber::ENUM_OUT_8079:
-					case MessageNumber::ENUM_OUT_807C:
-					case MessageNumber::ENUM_OUT_807D:
-					case MessageNumber::ENUM_OUT_807E:
-					case MessageNumber::ENUM_OUT_8081:
-					case MessageNumber::ENUM_OUT_808C:
-					case MessageNumber::ENUM_OUT_808D:
-					case MessageNumber::ENUM_OUT_OP_CHECK_REF_STEP_808E:
-					case MessageNumber::ENUM_OUT_808F:
-					case MessageNumber::ENUM_OUT_80A8:
-					case MessageNumber::ENUM_OUT_80A9:
-					case MessageNumber::ENUM_OUT_80AA:
-					case MessageNumber::ENUM_OUT_80AB:
-					case MessageNumber::ENUM_OUT_80AE:
-					case MessageNumber::ENUM_OUT_LOAD_BASEHEATER_80AF:
-					case MessageNumber::ENUM_OUT_80B1:
-					case MessageNumber::ENUM_OUT_80CE:
-					case MessageNumber::VAR_OUT_8200:
-					case MessageNumber::VAR_OUT_8201:
-					case MessageNumber::VAR_OUT_INSTALL_COMP_NUM_8202:
-					case MessageNumber::VAR_OUT_SENSOR_AIROUT_8204:
-					case MessageNumber::VAR_OUT_SENSOR_HIGHPRESS_8206:
-					case MessageNumber::VAR_OUT_SENSOR_LOWPRESS_8208:
-					case MessageNumber::VAR_OUT_SENSOR_DISCHARGE1_820A:
-					case MessageNumber::VAR_OUT_SENSOR_CT1_8217:
-					case MessageNumber::VAR_OUT_SENSOR_CONDOUT_8218:
-					case MessageNumber::VAR_OUT_SENSOR_SUCTION_821A:
-					case MessageNumber::VAR_OUT_CONTROL_TARGET_DISCHARGE_8223:
-					case MessageNumber::VAR_OUT_8225:
-					case MessageNumber::VAR_OUT_LOAD_OUTEEV1_8229:
-					case MessageNumber::VAR_OUT_LOAD_OUTEEV4_822C:
-					case MessageNumber::VAR_OUT_8233:
-					case MessageNumber::VAR_OUT_ERROR_CODE_8235:
-					case MessageNumber::VAR_OUT_CONTROL_ORDER_CFREQ_COMP1_8236:
-					case MessageNumber::VAR_OUT_CONTROL_TARGET_CFREQ_COMP1_8237:
-					case MessageNumber::VAR_OUT_CONTROL_CFREQ_COMP1_8238:
-					case MessageNumber::VAR_OUT_8239:
-					case MessageNumber::VAR_OUT_SENSOR_DCLINK_VOLTAGE_823B:
-					case MessageNumber::VAR_OUT_LOAD_FANRPM1_823D:
-					case MessageNumber::VAR_OUT_LOAD_FANRPM2_823E:
-					case MessageNumber::VAR_OUT_823F:
-					case MessageNumber::VAR_OUT_8243:
-					case MessageNumber::VAR_OUT_8247:
-					case MessageNumber::VAR_OUT_8248:
- 					case MessageNumber::VAR_OUT_8249:
-                    case MessageNumber::VAR_OUT_824B:
-                    case MessageNumber::VAR_OUT_824C:
-					case MessageNumber::VAR_OUT_CONTROL_REFRIGERANTS_VOLUME_824F:
-					case MessageNumber::VAR_OUT_SENSOR_IPM1_8254:
-					case MessageNumber::VAR_OUT_CONTROL_ORDER_CFREQ_COMP2_8274:
-					case MessageNumber::VAR_OUT_CONTROL_TARGET_CFREQ_COMP2_8275:
-					case MessageNumber::VAR_OUT_SENSOR_TOP1_8280:
-					case MessageNumber::VAR_OUT_INSTALL_CAPA_8287:
-					case MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_HIGH_PRESSURE_829F:
-					case MessageNumber::VAR_OUT_SENSOR_SAT_TEMP_LOW_PRESSURE_82A0:
-					case MessageNumber::VAR_OUT_82A2:
-					case MessageNumber::VAR_OUT_82B5:
-					case MessageNumber::VAR_OUT_82B6:
-					case MessageNumber::VAR_OUT_PROJECT_CODE_82BC:
-					case MessageNumber::VAR_OUT_82D9:
-					case MessageNumber::VAR_OUT_82D4:
-					case MessageNumber::VAR_OUT_82DA:
-					case MessageNumber::VAR_OUT_PHASE_CURRENT_82DB:
-					case MessageNumber::VAR_OUT_82DC:
-					case MessageNumber::VAR_OUT_82DD:
-					case MessageNumber::VAR_OUT_SENSOR_EVAIN_82DE:
-					case MessageNumber::VAR_OUT_SENSOR_TW1_82DF:
-					case MessageNumber::VAR_OUT_SENSOR_TW2_82E0:
-					case MessageNumber::VAR_OUT_82E1:
-					case MessageNumber::VAR_OUT_PRODUCT_OPTION_CAPA_82E3:
-					case MessageNumber::VAR_OUT_82ED:
-					case MessageNumber::LVAR_OUT_LOAD_COMP1_RUNNING_TIME_8405:
-					case MessageNumber::LVAR_OUT_8406:
-					case MessageNumber::LVAR_OUT_8408:
-					case MessageNumber::LVAR_OUT_840F:
-					case MessageNumber::LVAR_OUT_8410:
-					case MessageNumber::LVAR_OUT_8411:
-					case MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413:
-					case MessageNumber::LVAR_OUT_8414:
-					case MessageNumber::LVAR_OUT_8417:
-					case MessageNumber::LVAR_OUT_841F:
-					{
-                        if (mqtt_connected())
-                        {
-						    mqtt_publish("samsung_ehs/" + long_to_hex((uint16_t)message.messageNumber) + "/state", std::to_string(message.value));
-						    break;
-						} else {
-                         //   ESP_LOGW(TAG, "Message processed, but MQTT client is not connected. Dropping payload.");
-                        }
-					}	
-					default:	
-					{	
-                        ESP_LOGV(TAG, "Skipped message s:%s d:%s %02lx %d", packet_.sa.to_string().c_str(), packet_.da.to_string().c_str(), message.messageNumber, message.value);																															
-						break;
-					}																																																	
-                } 
+                // derived metrics need their inputs, published or not
+                target->publisher().update_derived(message);
+
+                const MessageInfo *info = find_message_info(message.messageNumber);
+                if (deduped && target->publisher().needs_every_sample(message.messageNumber, info))
+                    target->frame_dedup().decode_always();
+
+                if (info == nullptr)
+                {
+                    ESP_LOGV(TAG, "Skipped message s:%s d:%s %02lx %d", packet_.sa.to_string().c_str(), packet_.da.to_string().c_str(), message.messageNumber, message.value);
+                    continue;
+                }
+
+                // send relevant EHS messages via MQTT
+                target->publisher().announce(*info, packet_.sa);
+                target->publisher().publish(message, *info, packet_.sa, decoded_at);
             }
         }
 
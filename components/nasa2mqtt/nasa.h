@@ -104,6 +104,8 @@ namespace esphome
             LVAR_AD_418 = 0x418,
             LVAR_AD_419 = 0x419,
             LVAR_AD_41B = 0x41B,
+            STR_AD_ID_SERIAL_NUMBER_607 = 0x607,
+            STR_AD_ID_MODEL_NAME_61F = 0x61F,
             ENUM_IN_OPERATION_POWER_4000 = 0x4000,
             ENUM_IN_OPERATION_MODE_4001 = 0x4001,
             ENUM_IN_OPERATION_MODE_REAL_4002 = 0x4002,
@@ -355,7 +357,13 @@ namespace esphome
             static Address get_my_address();
 
             void decode(std::vector<uint8_t> &data, unsigned int index);
+            void encode(std::vector<uint8_t> &data);
             std::string to_string();
+
+            bool operator==(const Address &other) const
+            {
+                return aclass == other.aclass && channel == other.channel && address == other.address;
+            }
         };
 
         struct Command
@@ -370,13 +378,16 @@ namespace esphome
             uint8_t size = 3;
 
             void decode(std::vector<uint8_t> &data, unsigned int index);
+            void encode(std::vector<uint8_t> &data);
             std::string to_string();
         };
 
-        struct Buffer
+        // Payload of a structure message, pointing into the frame it was decoded from,
+        // so only valid while that frame is processed
+        struct StructureView
         {
-            uint8_t size;
-            uint8_t data[255];
+            const uint8_t *data;
+            uint16_t size;
         };
 
         struct MessageSet
@@ -386,7 +397,7 @@ namespace esphome
             union
             {
                 long value;
-                Buffer structure;
+                StructureView structure;
             };
             uint16_t size = 2;
 
@@ -398,7 +409,12 @@ namespace esphome
                 // this->_msgIndex = (ushort) ((uint) messageNumber & 511U);
             }
 
-            static MessageSet decode(std::vector<uint8_t> &data, unsigned int index, int capacity);
+            // Bytes taken by the message set at data, 0 when it does not fit into the available bytes
+            // or is a structure among other sets (capacity is the number of sets in the frame)
+            static uint16_t encoded_size(const uint8_t *data, uint16_t available, int capacity);
+            // Unchecked: size must come from encoded_size
+            static MessageSet decode(const uint8_t *data, uint16_t size);
+            void encode(std::vector<uint8_t> &data);
 
             std::string to_string();
         };
@@ -410,11 +426,22 @@ namespace esphome
             Command pcommand;
             std::vector<MessageSet> messages;
 
+            // New packet from us (JIGTester) to da, packetNumber is the per-bus counter
+            static Packet create(Address da, DataType dataType, uint8_t &packetNumber);
+
             bool decode(std::vector<uint8_t> &data);
+            // decode() in two steps: validation (size, crc) plus addresses and command first, messages
+            // only for frames that are worth it. decode_messages checks the layout of all message sets
+            // in one pass and fails without decoding any when one of them does not fit.
+            bool decode_header(std::vector<uint8_t> &data);
+            bool decode_messages(std::vector<uint8_t> &data);
+            std::vector<uint8_t> encode();
             std::string to_string();
         };
 
-        void process_nasa_message(std::vector<uint8_t> data, MessageTarget *target);
+        uint16_t crc16(std::vector<uint8_t> &data, int startIndex, int length);
+
+        void process_nasa_message(std::vector<uint8_t> &data, MessageTarget *target);
 
     } // namespace nasa2mqtt
 } // namespace esphome
@@ -2,7 +2,13 @@
 #include "nasa2mqtt.h"
 #include "mqtt.h"
 #include "util.h"
+#include "nasa.h"
+#include "footprint.h"
+#include <memory>
 #include <vector>
+#if defined(USE_NASA2MQTT_METRICS) && !defined(USE_ARDUINO)
+#include <esp_http_server.h>
+#endif
 
 namespace esphome
 {
@@ -10,9 +16,58 @@ namespace esphome
   {
     static const char *TAG = "NASA2MQTT";
 
+#ifdef USE_NASA2MQTT_METRICS
+    // one endpoint for all buses
+    static MetricsHandler *metrics_handler = nullptr;
+
+    void MetricsHandler::handleRequest(AsyncWebServerRequest *request)
+    {
+      static const char *CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+      auto renderer = std::make_shared<MetricsRenderer>();
+#ifdef USE_ARDUINO
+      // the server pulls each chunk into its own send buffer
+      request->send(request->beginChunkedResponse(CONTENT_TYPE, [renderer](uint8_t *buffer, size_t max_length, size_t index) -> size_t
+                                                   { return renderer->render((char *)buffer, max_length); }));
+#else
+      // the ESP-IDF wrapper has no chunked filler and its response stream keeps the whole body in
+      // heap until sent, so the chunks go straight to the underlying httpd request
+      httpd_req_t *req = *request;
+      httpd_resp_set_type(req, CONTENT_TYPE);
+      char buffer[256];
+      size_t length;
+      while ((length = renderer->render(buffer, sizeof(buffer))) > 0)
+      {
+        if (httpd_resp_send_chunk(req, buffer, length) != ESP_OK)
+          return;
+      }
+      httpd_resp_send_chunk(req, nullptr, 0);
+#endif
+    }
+#endif
+
     void NASA2MQTT::setup()
     {
       ESP_LOGI(TAG, "setup: Starting MQTT client.");
+      publisher_.derived.setup(publisher_.topic_prefix);
+      publisher_.filter.setup(publisher_.topic_prefix);
+      mqtt_subscribe(publisher_.topic("nasa2mqtt/filter"));
+      if (publisher_.history.enabled())
+        mqtt_subscribe(publisher_.topic("nasa2mqtt/history/get"));
+      if (write_scheduler_.enabled())
+        mqtt_subscribe(publisher_.topic("+/set"));
+#ifdef USE_NASA2MQTT_METRICS
+      if (metrics_base_ != nullptr)
+      {
+        publisher_.metrics.bus = publisher_.topic_prefix;
+        register_metrics(&publisher_.metrics);
+        if (metrics_handler == nullptr)
+        {
+          metrics_handler = new MetricsHandler(metrics_path_);
+          metrics_base_->init();
+          metrics_base_->add_handler(metrics_handler);
+        }
+      }
+#endif
       // Only start the client once at boot --> doesn't work, crashes ESP32!
       //mqtt_connect(mqtt_host, mqtt_port, mqtt_username, mqtt_password);
     }
@@ -53,6 +108,73 @@ namespace esphome
       ESP_LOGCONFIG(TAG, "  Indoor:  %s", (knownIndoor.length() == 0 ? "-" : knownIndoor.c_str()));
       if (knownOther.length() > 0)
         ESP_LOGCONFIG(TAG, "  Other:   %s", knownOther.c_str());
+
+      publisher_.derived.save();
+      footprint.sample();
+
+      if (mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/publisher"), publisher_.stats_to_json());
+      if (mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/sequence"), sequence_tracker_.stats_to_json());
+      if (mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/bus"), bus_analyzer_.stats_to_json(millis()));
+      if (mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/footprint"), footprint.stats_to_json());
+      if (mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/mqtt"), mqtt_stats_to_json());
+      if (request_scheduler_.enabled() && mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/requests"), request_scheduler_.stats_to_json());
+      if (write_scheduler_.enabled() && mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/writes"), write_scheduler_.stats_to_json());
+      if (frame_dedup_.enabled() && mqtt_connected())
+        mqtt_publish(publisher_.topic("nasa2mqtt/dedup"), frame_dedup_.stats_to_json());
+    }
+
+    void NASA2MQTT::handle_packet(Packet &packet)
+    {
+      if (!(packet.da == Address::get_my_address()))
+        return;
+
+      if (!write_scheduler_.handle_ack(packet, millis()))
+        request_scheduler_.handle_response(packet, millis());
+    }
+
+    // <prefix>/<message number in hex>/set with the raw value as payload, the publish filter or a history query
+    void NASA2MQTT::handle_command(const MqttMessage &message)
+    {
+      if (message.topic == publisher_.topic("nasa2mqtt/filter"))
+      {
+        ESP_LOGI(TAG, "Publish filter: %s", message.payload.c_str());
+        publisher_.filter.apply(message.payload);
+        return;
+      }
+
+      if (message.topic == publisher_.topic("nasa2mqtt/history/get"))
+      {
+        std::string suffix, payload;
+        if (publisher_.history.query(message.payload, millis(), suffix, payload))
+          mqtt_publish(publisher_.topic(suffix), payload);
+        else
+          ESP_LOGW(TAG, "Invalid history query '%s'", message.payload.c_str());
+        return;
+      }
+
+      const std::string prefix = publisher_.topic_prefix + "/";
+      const std::string suffix = "/set";
+      if (message.topic.rfind(prefix, 0) != 0 || message.topic.length() <= prefix.length() + suffix.length())
+        return;
+
+      std::string number = message.topic.substr(prefix.length(), message.topic.length() - prefix.length() - suffix.length());
+      char *end;
+      long value = strtol(message.payload.c_str(), &end, 10);
+      if (message.payload.empty() || *end != '\0')
+      {
+        ESP_LOGW(TAG, "Invalid value '%s' on %s", message.payload.c_str(), message.topic.c_str());
+        return;
+      }
+
+      ESP_LOGD(TAG, "Command %s = %ld", number.c_str(), value);
+      write_scheduler_.enqueue((MessageNumber)hex_to_int(number), value, message.received);
     }
 
     void NASA2MQTT::dump_config()
@@ -63,61 +185,66 @@ namespace esphome
 
     void NASA2MQTT::loop()
     {
+      mqtt_loop();
       if (data_processing_init)
         return;
 
       const uint32_t now = millis();
-      if (receiving_ && (now - last_transmission_ >= 500))
-      {
-        ESP_LOGW(TAG, "Last transmission too long ago. Reset RX index.");
-        data_.clear();
-        receiving_ = false;
-      }
+      framer_.check_timeout(now);
 
-      last_transmission_ = now;
       while (available())
       {
         uint8_t c;
 
         read_byte(&c);
-        if (c == 0x32 && !receiving_) // start-byte found
-        {
-          receiving_ = true;
-          bytes_ = 0;
-          size_ = 0;
-          data_.clear();
-        }
-        if (receiving_)
+        if (framer_.push(c, now))
         {
-          data_.push_back(c);
-          bytes_++;
-          switch (bytes_)
-          {
-            case 1: // start byte found
-              break;
-            case 2: // first part of size found
-            {
-              size_ = c;
-              break;
-            }
-            case 3: // second part of size found
-            {
-              size_ = (int)size_ << 8 | c;
-              ESP_LOGV(TAG, "Message size in packet: %d", size_);
-              break;  
-            }
-            default: // subsequent bytes 
-            {
-              if (bytes_ >= (size_+2)) // end byte found
-              {  
-                receiving_ = false;
-                process_message(data_, this);
-              }
-              break;
-            }
-          }
+          bus_analyzer_.add_frame(framer_.data(), framer_.frame_start(), framer_.last_byte());
+          footprint.frame_begin();
+          process_message(framer_.data(), this);
+          footprint.frame_end();
         }
       }
+
+      publisher_.loop();
+
+      auto &metrics = publisher_.metrics;
+      metrics.set_counter(MetricsCounter::RequestsSent, request_scheduler_.requests_sent);
+      metrics.set_counter(MetricsCounter::Responses, request_scheduler_.responses);
+      metrics.set_counter(MetricsCounter::RequestTimeouts, request_scheduler_.timeouts);
+      metrics.set_counter(MetricsCounter::WriteCommands, write_scheduler_.commands);
+      metrics.set_counter(MetricsCounter::WriteAcks, write_scheduler_.acks);
+      metrics.set_counter(MetricsCounter::WriteNacks, write_scheduler_.nacks);
+      metrics.set_counter(MetricsCounter::WriteRetries, write_scheduler_.retries);
+      metrics.set_counter(MetricsCounter::WriteFailures, write_scheduler_.failures);
+      metrics.set_counter(MetricsCounter::FramesLost, sequence_tracker_.lost);
+      metrics.set_counter(MetricsCounter::Retransmissions, sequence_tracker_.duplicates);
+      metrics.set_counter(MetricsCounter::DedupLookups, frame_dedup_.lookups);
+      metrics.set_counter(MetricsCounter::DedupHits, frame_dedup_.hits);
+
+      MqttMessage command;
+      while (mqtt_receive(publisher_.topic_prefix + "/", command))
+        handle_command(command);
+
+      // Only talk while nobody else does, writes go before reads
+      if (framer_.receiving() || now - framer_.last_byte() < BUS_IDLE_GAP_MS || now - last_tx_ < BUS_IDLE_GAP_MS)
+        return;
+
+      if (write_scheduler_.poll(now, packet_number_, tx_frame_))
+      {
+        ESP_LOGV(TAG, "Sending write %s", bytes_to_hex(tx_frame_).c_str());
+      }
+      else if (bus_analyzer_.recent_utilization(now) < MAX_REQUEST_UTILIZATION &&
+               request_scheduler_.poll(now, packet_number_, tx_frame_))
+      {
+        ESP_LOGV(TAG, "Sending read request %s", bytes_to_hex(tx_frame_).c_str());
+      }
+      else
+      {
+        return;
+      }
+      write_array(tx_frame_);
+      last_tx_ = now;
     }
   } // namespace nasa2mqtt
 } // namespace esphome
@@ -6,6 +6,15 @@
 #include "esphome/core/component.h"
 #include "esphome/components/uart/uart.h"
 #include "protocol.h"
+#include "scheduler.h"
+#include "mqtt.h"
+#include "publisher.h"
+#include "sequence.h"
+#include "dedup.h"
+#include "analyzer.h"
+#ifdef USE_NASA2MQTT_METRICS
+#include "esphome/components/web_server_base/web_server_base.h"
+#endif
 
 namespace esphome
 {
@@ -13,6 +22,25 @@ namespace esphome
   {
     class NasaProtocol;
 
+#ifdef USE_NASA2MQTT_METRICS
+    // Serves the metrics of all buses in OpenMetrics text format, rendered chunk by chunk
+    class MetricsHandler : public AsyncWebHandler
+    {
+    public:
+      MetricsHandler(std::string path) : path_(path) {}
+
+      bool canHandle(AsyncWebServerRequest *request) override
+      {
+        return request->method() == HTTP_GET && request->url() == path_.c_str();
+      }
+
+      void handleRequest(AsyncWebServerRequest *request) override;
+
+    private:
+      std::string path_;
+    };
+#endif
+
     class NASA2MQTT : public PollingComponent,
                        public uart::UARTDevice,
                        public MessageTarget
@@ -30,6 +58,25 @@ namespace esphome
         addresses_.insert(address);
       }
 
+      void handle_packet(Packet &packet) override;
+      Packet &packet() override
+      {
+        return packet_;
+      }
+      Publisher &publisher() override
+      {
+        return publisher_;
+      }
+      SequenceTracker &sequence_tracker() override
+      {
+        return sequence_tracker_;
+      }
+      FrameDedup &frame_dedup() override
+      {
+        return frame_dedup_;
+      }
+      void handle_command(const MqttMessage &message);
+
       void set_mqtt(std::string host, int port, std::string username, std::string password)
       {
        mqtt_host = host;
@@ -38,6 +85,110 @@ namespace esphome
        mqtt_password = password;
       }
 
+      // all buses share one MQTT client, these apply to it
+      void set_mqtt_tls(std::string ca)
+      {
+        mqtt_set_tls(ca);
+      }
+
+      void set_mqtt_session(std::string client_id, bool clean_session)
+      {
+        mqtt_set_session(client_id, clean_session);
+      }
+
+      void set_mqtt_inflight(uint8_t window, uint32_t retransmit_timeout)
+      {
+        mqtt_set_inflight(window, retransmit_timeout);
+      }
+
+      void add_request_message(uint16_t number)
+      {
+        request_scheduler_.add_message(number);
+      }
+
+      void set_request_interval(uint32_t interval)
+      {
+        request_scheduler_.set_interval(interval);
+      }
+
+      void set_request_batch_size(uint8_t batch_size)
+      {
+        request_scheduler_.set_batch_size(batch_size);
+      }
+
+      void add_rate_limit(uint16_t number, uint32_t interval, uint8_t burst)
+      {
+        publisher_.limiter.add_limit((MessageNumber)number, interval, burst);
+      }
+
+      void add_rate_limit(MessageGroup group, uint32_t interval, uint8_t burst)
+      {
+        publisher_.limiter.add_limit(group, interval, burst);
+      }
+
+      void add_aggregate(uint16_t number, uint32_t window)
+      {
+        publisher_.aggregator.add_series((MessageNumber)number, window);
+      }
+
+      void set_aggregate_publish_raw(uint16_t number, bool publish_raw)
+      {
+        publisher_.aggregator.set_publish_raw((MessageNumber)number, publish_raw);
+      }
+
+      void set_derived_metrics(bool enabled)
+      {
+        publisher_.derived.set_enabled(enabled);
+      }
+
+      void add_rule(std::string name, uint16_t number, RuleCondition condition, long threshold, long hysteresis, uint32_t duration)
+      {
+        publisher_.rules.add_rule(name, (MessageNumber)number, condition, threshold, hysteresis, duration);
+      }
+
+      void add_change_rule(std::string name, uint16_t number, bool has_from, long from, bool has_to, long to)
+      {
+        publisher_.rules.add_change_rule(name, (MessageNumber)number, has_from, from, has_to, to);
+      }
+
+      void add_history(uint16_t number, uint32_t bytes, uint32_t interval)
+      {
+        publisher_.history.add_series((MessageNumber)number, bytes, interval);
+      }
+
+      void set_discovery(std::string prefix, uint32_t interval, uint8_t burst)
+      {
+        publisher_.discovery.setup(prefix, interval, burst);
+      }
+
+      void set_state_documents(uint32_t interval, uint32_t delta_interval)
+      {
+        publisher_.states.setup(interval, delta_interval);
+      }
+
+      void set_frame_dedup(uint32_t max_age)
+      {
+        frame_dedup_.setup(max_age);
+      }
+
+      void add_write_message(uint16_t number)
+      {
+        write_scheduler_.allow_message(number);
+      }
+
+      void set_topic_prefix(std::string prefix)
+      {
+        publisher_.topic_prefix = prefix;
+      }
+
+#ifdef USE_NASA2MQTT_METRICS
+      void set_metrics(web_server_base::WebServerBase *base, std::string path)
+      {
+        metrics_base_ = base;
+        metrics_path_ = path;
+      }
+#endif
+
       void set_debug_log_messages(bool value)
       {
         debug_log_messages = value;
@@ -50,12 +201,24 @@ namespace esphome
 
       std::set<std::string> addresses_;
 
-      std::vector<uint8_t> data_;
-      bool receiving_{false};
-      uint32_t last_transmission_{0};
-      uint16_t bytes_ = 0;
-      uint16_t size_ = 0;
+      FrameAssembler framer_;
       bool data_processing_init = true;
+      uint32_t last_tx_{0};
+
+      Packet packet_;
+      uint8_t packet_number_{0};
+
+      RequestScheduler request_scheduler_;
+      WriteScheduler write_scheduler_;
+      Publisher publisher_;
+      SequenceTracker sequence_tracker_;
+      FrameDedup frame_dedup_;
+      BusAnalyzer bus_analyzer_;
+      std::vector<uint8_t> tx_frame_;
+#ifdef USE_NASA2MQTT_METRICS
+      web_server_base::WebServerBase *metrics_base_{nullptr};
+      std::string metrics_path_;
+#endif
 
       // settings from yaml
       std::string mqtt_host = "";
@@ -9,12 +9,73 @@ namespace esphome
 {
     namespace nasa2mqtt
     {
-        bool debug_log_messages = false;
-        bool debug_log_messages_raw = false;
+        // Frames on a real bus stay well below this, so the buffer never grows on the way
+        static const size_t FRAME_RESERVE = 256;
+
+        FrameAssembler::FrameAssembler()
+        {
+            data_.reserve(FRAME_RESERVE);
+        }
+
+        void FrameAssembler::check_timeout(uint32_t now)
+        {
+            if (receiving_ && (now - last_byte_ >= 500))
+            {
+                ESP_LOGW(TAG, "Last transmission too long ago. Reset RX index.");
+                data_.clear();
+                receiving_ = false;
+            }
+        }
+
+        bool FrameAssembler::push(uint8_t c, uint32_t now)
+        {
+            last_byte_ = now;
+            if (c == 0x32 && !receiving_) // start-byte found
+            {
+                receiving_ = true;
+                frame_start_ = now;
+                bytes_ = 0;
+                size_ = 0;
+                data_.clear();
+            }
+            if (!receiving_)
+                return false;
+
+            data_.push_back(c);
+            bytes_++;
+            switch (bytes_)
+            {
+            case 1: // start byte found
+                break;
+            case 2: // first part of size found
+                size_ = c;
+                break;
+            case 3: // second part of size found
+                size_ = (int)size_ << 8 | c;
+                ESP_LOGV(TAG, "Message size in packet: %d", size_);
+                if (size_ >= 1500)
+                {
+                    ESP_LOGV(TAG, "Message size %d too large, waiting for next start byte", size_);
+                    receiving_ = false;
+                    break;
+                }
+                // a larger frame grows the buffer once, not step by step
+                data_.reserve(size_ + 2);
+                break;
+            default: // subsequent bytes
+                if (bytes_ >= (size_ + 2)) // end byte found
+                {
+                    receiving_ = false;
+                    return true;
+                }
+                break;
+            }
+            return false;
+        }
 
         void process_message(std::vector<uint8_t> &data, MessageTarget *target)
         {
-            if (debug_log_messages_raw)
+            if (target->debug_log_messages_raw)
             {
                 ESP_LOGW(TAG, "RAW: %s", bytes_to_hex(data).c_str());
             }
@@ -7,14 +7,67 @@ namespace esphome
 {
     namespace nasa2mqtt
     {
-        extern bool debug_log_messages;
-        extern bool debug_log_messages_raw;
-
+        struct Packet;
+        class Publisher;
+        class SequenceTracker;
+        class FrameDedup;
 
         class MessageTarget
         {
         public:
             virtual void register_address(const std::string address) = 0;
+            virtual void handle_packet(Packet &packet) = 0;
+            virtual Publisher &publisher() = 0;
+            // Decoder state of this bus, reused for every frame
+            virtual Packet &packet() = 0;
+            // Packet numbers seen per source device on this bus
+            virtual SequenceTracker &sequence_tracker() = 0;
+            // Repeated notifications skipped before decoding on this bus
+            virtual FrameDedup &frame_dedup() = 0;
+
+            bool debug_log_messages = false;
+            bool debug_log_messages_raw = false;
+        };
+
+        // Cuts the byte stream of a bus into frames: start byte 0x32, two size bytes, payload
+        class FrameAssembler
+        {
+        public:
+            FrameAssembler();
+
+            // Returns true when c completed a frame, which is then in data(), read between
+            // frame_start() and last_byte()
+            bool push(uint8_t c, uint32_t now);
+            // Drops a partial frame when the bus went quiet in the middle of it
+            void check_timeout(uint32_t now);
+
+            bool receiving()
+            {
+                return receiving_;
+            }
+
+            uint32_t last_byte()
+            {
+                return last_byte_;
+            }
+
+            uint32_t frame_start()
+            {
+                return frame_start_;
+            }
+
+            std::vector<uint8_t> &data()
+            {
+                return data_;
+            }
+
+        private:
+            std::vector<uint8_t> data_;
+            bool receiving_ = false;
+            uint32_t last_byte_ = 0;
+            uint32_t frame_start_ = 0;
+            uint16_t bytes_ = 0;
+            uint16_t size_ = 0;
         };
 
         void process_message(std::vector<uint8_t> &data, MessageTarget *target);
@@ -0,0 +1,259 @@
+#include <cstdio>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "publisher.h"
+#include "mqtt.h"
+#include "structure.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        const std::string &Publisher::state_topic(MessageNumber messageNumber)
+        {
+            char number[8];
+            snprintf(number, sizeof(number), "/%02x", (uint16_t)messageNumber);
+            state_topic_.assign(topic_prefix);
+            state_topic_.append(number);
+            state_topic_.append("/state");
+            return state_topic_;
+        }
+
+        void Publisher::publish(MessageSet &message, const MessageInfo &info, const Address &source, uint32_t decoded_at)
+        {
+            // scrapes see every decoded value, whatever MQTT gets
+            if (message.type != Structure)
+            {
+                metrics.set_value(info, message.value);
+                rules.evaluate(info, message.value, millis(), [this](const std::string &suffix, const std::string &payload)
+                               { publish_event(suffix, payload); });
+                history.add(info, message.value, millis());
+            }
+
+            if (!filter.enabled(info))
+                return;
+
+            if (message.type != Structure && states.enabled())
+                states.update(info, source, message.value, millis());
+
+            // model names and the like: rare, so no limits or aggregates
+            if (message.type == Structure)
+            {
+                publish_topic(long_to_hex((uint16_t)message.messageNumber) + "/state", structure_to_payload(message.messageNumber, message.structure));
+                return;
+            }
+
+            const uint32_t now = millis();
+            if (info.priority == MessagePriority::Critical)
+            {
+                publish_critical(message.messageNumber, std::to_string(message.value), decoded_at);
+                return;
+            }
+
+            if (!aggregator.add(info, message.value, now))
+                return;
+
+            if (!limiter.allow(info, message.value, decoded_at, now))
+                return;
+
+            publish_normal(message.messageNumber, message.value, decoded_at);
+        }
+
+        void Publisher::publish_normal(MessageNumber messageNumber, long value, uint32_t decoded_at)
+        {
+            if (!mqtt_connected())
+            {
+                dropped++;
+                return;
+            }
+            if (mqtt_congested() || !mqtt_publish(state_topic(messageNumber), std::to_string(value)))
+            {
+                defer(messageNumber, value, decoded_at);
+                return;
+            }
+            published++;
+            latency_normal.add(micros() - decoded_at);
+        }
+
+        void Publisher::defer(MessageNumber messageNumber, long value, uint32_t decoded_at)
+        {
+            deferred++;
+            for (auto &waiting : deferred_)
+            {
+                if (waiting.messageNumber == messageNumber)
+                {
+                    waiting.value = value;
+                    waiting.decoded_at = decoded_at;
+                    return;
+                }
+            }
+            if (deferred_.size() == MAX_DEFERRED)
+            {
+                dropped++;
+                return;
+            }
+            deferred_.push_back({messageNumber, value, decoded_at});
+        }
+
+        void Publisher::flush_deferred()
+        {
+            // in place, so a value that has to wait again keeps its slot
+            size_t kept = 0;
+            for (size_t i = 0; i < deferred_.size(); i++)
+            {
+                const DeferredValue waiting = deferred_[i];
+                if (kept > 0 || mqtt_congested() || !mqtt_publish(state_topic(waiting.messageNumber), std::to_string(waiting.value)))
+                {
+                    deferred_[kept++] = waiting;
+                    continue;
+                }
+                published++;
+                latency_normal.add(micros() - waiting.decoded_at);
+            }
+            deferred_.resize(kept);
+        }
+
+        void Publisher::announce(const MessageInfo &info, const Address &source)
+        {
+            if (discovery.enabled() && filter.enabled(info))
+                discovery.seen(info, source);
+        }
+
+        void Publisher::update_derived(MessageSet &message)
+        {
+            derived.update(message.messageNumber, message.value, millis(), [this](const std::string &suffix, const std::string &payload)
+                           { publish_topic(suffix, payload); });
+        }
+
+        void Publisher::publish_topic(const std::string &suffix, const std::string &payload)
+        {
+            if (mqtt_connected() && !mqtt_congested() && mqtt_publish(topic(suffix), payload))
+                published++;
+            else
+                dropped++;
+        }
+
+        void Publisher::publish_critical(MessageNumber messageNumber, const std::string &payload, uint32_t decoded_at)
+        {
+            if (!mqtt_connected() || !mqtt_publish(state_topic(messageNumber), payload, 1, true))
+            {
+                hold(messageNumber, payload, decoded_at);
+                return;
+            }
+            published++;
+            latency_critical.add(micros() - decoded_at);
+        }
+
+        void Publisher::hold(MessageNumber messageNumber, const std::string &payload, uint32_t decoded_at)
+        {
+            for (auto &held : held_)
+            {
+                if (held.messageNumber == messageNumber)
+                {
+                    held.payload = payload;
+                    held.decoded_at = decoded_at;
+                    return;
+                }
+            }
+            ESP_LOGD(TAG, "Holding critical message %s until MQTT is connected", long_to_hex((uint16_t)messageNumber).c_str());
+            held_.push_back({messageNumber, payload, decoded_at});
+        }
+
+        void Publisher::loop()
+        {
+            const uint32_t now = millis();
+            limiter.flush(now, [this](MessageNumber messageNumber, long value, uint32_t decoded_at)
+                          { publish_normal(messageNumber, value, decoded_at); });
+            aggregator.flush(now, [this](const std::string &suffix, const std::string &payload)
+                             { publish_topic(suffix, payload); });
+
+            metrics.set_counter(MetricsCounter::Published, published);
+            metrics.set_counter(MetricsCounter::Dropped, dropped);
+            metrics.set_counter(MetricsCounter::RateLimited, limiter.limited);
+            metrics.set_counter(MetricsCounter::Deferred, deferred);
+
+            rules.loop(now, [this](const std::string &suffix, const std::string &payload)
+                       { publish_event(suffix, payload); });
+
+            if (!mqtt_connected())
+            {
+                // nothing comes of them once MQTT is back
+                dropped += deferred_.size();
+                deferred_.clear();
+                return;
+            }
+
+            if (!deferred_.empty())
+                flush_deferred();
+
+            if (states.enabled())
+            {
+                states.loop(now, topic_prefix, [](const std::string &topic, const std::string &payload, bool retain)
+                            { return !mqtt_congested() && mqtt_publish(topic, payload, 0, retain); });
+            }
+
+            if (discovery.enabled())
+            {
+                discovery.loop(now, topic_prefix, [this](MessageNumber messageNumber) -> const std::string &
+                               { return state_topic(messageNumber); },
+                               [](const std::string &topic, const std::string &payload)
+                               { return !mqtt_congested() && mqtt_publish(topic, payload, 1, true); });
+            }
+
+            if (!held_events_.empty())
+            {
+                std::vector<std::pair<std::string, std::string>> events;
+                events.swap(held_events_);
+                for (auto &event : events)
+                    publish_event(event.first, event.second);
+            }
+
+            if (held_.empty())
+                return;
+
+            std::vector<HeldMessage> held;
+            held.swap(held_);
+            for (auto &message : held)
+            {
+                publish_critical(message.messageNumber, message.payload, message.decoded_at);
+            }
+        }
+
+        void Publisher::publish_event(const std::string &suffix, const std::string &payload)
+        {
+            if (mqtt_connected() && !mqtt_congested() && mqtt_publish(topic(suffix), payload, 1))
+            {
+                published++;
+                return;
+            }
+
+            if (held_events_.size() == MAX_HELD_EVENTS)
+            {
+                held_events_.erase(held_events_.begin());
+                dropped++;
+            }
+            held_events_.emplace_back(suffix, payload);
+        }
+
+        std::string Publisher::stats_to_json()
+        {
+            std::string json = "{\"published\":" + std::to_string(published) +
+                               ",\"dropped\":" + std::to_string(dropped) +
+                               ",\"held\":" + std::to_string(held_.size()) +
+                               ",\"rate_limited\":" + std::to_string(limiter.limited) +
+                               ",\"deferred\":" + std::to_string(deferred) +
+                               ",\"events\":" + std::to_string(rules.events) +
+                               (history.enabled() ? ",\"history\":" + history.stats_to_json() : "") +
+                               (discovery.enabled() ? ",\"discovered\":" + std::to_string(discovery.announced) : "") +
+                               (states.enabled() ? ",\"state_documents\":" + states.stats_to_json() : "") +
+                               ",\"latency_us\":" + latency_normal.to_json() +
+                               ",\"critical_latency_us\":" + latency_critical.to_json() + "}";
+            latency_normal.reset();
+            latency_critical.reset();
+            return json;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
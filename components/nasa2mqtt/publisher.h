@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include "nasa.h"
+#include "catalog.h"
+#include "limiter.h"
+#include "aggregator.h"
+#include "derived.h"
+#include "filter.h"
+#include "metrics.h"
+#include "rules.h"
+#include "history.h"
+#include "discovery.h"
+#include "state.h"
+#include "util.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Last step between a decoded message and MQTT. Critical messages take their own lane:
+        // published immediately with QoS 1 and retain, and held (latest value only) while MQTT is down.
+        // Everything else feeds the window aggregates and passes the rate limiter first.
+        class Publisher
+        {
+        public:
+            // Root of every topic of this bus
+            std::string topic_prefix = "samsung_ehs";
+
+            std::string topic(const std::string &suffix)
+            {
+                return topic_prefix + "/" + suffix;
+            }
+            // Built in a buffer that is reused, so publishing a value does not allocate once warm;
+            // valid until the next call
+            const std::string &state_topic(MessageNumber messageNumber);
+
+            // source sent the message, decoded_at is micros() when the frame was taken from the bus.
+            // Messages switched off in the filter go no further than the metrics snapshot, the rules
+            // and the history; the others also go into the state documents.
+            void publish(MessageSet &message, const MessageInfo &info, const Address &source, uint32_t decoded_at);
+            // Queues the Home Assistant discovery config of a message the first time source sends it,
+            // unless the filter switched the message off
+            void announce(const MessageInfo &info, const Address &source);
+            // Aggregation windows, history series and the energy integrals count samples, so a frame with
+            // such a message is decoded every time, repeat or not. info is null outside the catalog.
+            bool needs_every_sample(MessageNumber messageNumber, const MessageInfo *info)
+            {
+                return derived.is_input(messageNumber) ||
+                       (info != nullptr && (aggregator.has_series(*info) || history.has_series(*info)));
+            }
+            // Feeds every decoded message into the derived metrics
+            void update_derived(MessageSet &message);
+            // Flushes held critical messages once MQTT is back, rate limited values that are due and
+            // summaries of completed aggregation windows
+            void loop();
+            // Counters plus decode-to-publish latency (us) per lane since the previous call
+            std::string stats_to_json();
+
+            uint32_t published = 0;
+            uint32_t dropped = 0;
+            uint32_t deferred = 0;
+            LatencyStats latency_normal;
+            LatencyStats latency_critical;
+            RateLimiter limiter;
+            Aggregator aggregator;
+            DerivedMetrics derived;
+            PublishFilter filter;
+            MetricsSnapshot metrics;
+            RuleEngine rules;
+            History history;
+            Discovery discovery;
+            StateDocuments states;
+
+        private:
+            struct HeldMessage
+            {
+                MessageNumber messageNumber;
+                std::string payload;
+                uint32_t decoded_at;
+            };
+
+            // suffix is relative to topic_prefix
+            void publish_topic(const std::string &suffix, const std::string &payload);
+            void publish_normal(MessageNumber messageNumber, long value, uint32_t decoded_at);
+            void publish_critical(MessageNumber messageNumber, const std::string &payload, uint32_t decoded_at);
+            void hold(MessageNumber messageNumber, const std::string &payload, uint32_t decoded_at);
+            void defer(MessageNumber messageNumber, long value, uint32_t decoded_at);
+            void flush_deferred();
+            void publish_event(const std::string &suffix, const std::string &payload);
+
+            static const size_t MAX_HELD_EVENTS = 16;
+            static const size_t MAX_DEFERRED = 32;
+
+            struct DeferredValue
+            {
+                MessageNumber messageNumber;
+                long value;
+                uint32_t decoded_at;
+            };
+
+            std::string state_topic_;
+            std::vector<HeldMessage> held_;
+            // While the MQTT outbox is congested, the latest value per message waits here. Aggregates
+            // and derived metrics are dropped instead, the next window brings fresh ones.
+            std::vector<DeferredValue> deferred_;
+            // Rule events go out with QoS 1, the latest few wait here while MQTT is down: topic suffix
+            // and payload
+            std::vector<std::pair<std::string, std::string>> held_events_;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
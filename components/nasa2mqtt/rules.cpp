@@ -0,0 +1,155 @@
+#include <algorithm>
+#include "esphome/core/log.h"
+#include "rules.h"
+#include "util.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        void RuleEngine::add_rule(const std::string &name, MessageNumber messageNumber, RuleCondition condition,
+                                  long threshold, long hysteresis, uint32_t duration)
+        {
+            Rule rule;
+            rule.name = name;
+            rule.condition = condition;
+            rule.threshold = threshold;
+            rule.hysteresis = hysteresis;
+            rule.duration = duration;
+            add(rule, messageNumber);
+        }
+
+        void RuleEngine::add_change_rule(const std::string &name, MessageNumber messageNumber,
+                                         bool has_from, long from, bool has_to, long to)
+        {
+            Rule rule;
+            rule.name = name;
+            rule.condition = RuleCondition::Change;
+            rule.has_from = has_from;
+            rule.threshold = from;
+            rule.has_to = has_to;
+            rule.hysteresis = to;
+            add(rule, messageNumber);
+        }
+
+        void RuleEngine::add(Rule rule, MessageNumber messageNumber)
+        {
+            const MessageInfo *info = find_message_info(messageNumber);
+            if (info == nullptr)
+            {
+                ESP_LOGW(TAG, "Rule %s: message %s is not decoded, ignoring it", rule.name.c_str(), long_to_hex((uint16_t)messageNumber).c_str());
+                return;
+            }
+            rule.index = catalog_index(*info);
+            rules_.push_back(rule);
+            built_ = false;
+        }
+
+        void RuleEngine::build()
+        {
+            std::stable_sort(rules_.begin(), rules_.end(), [](const Rule &a, const Rule &b)
+                             { return a.index < b.index; });
+
+            first_rule_.assign(catalog_size() + 1, 0);
+            size_t rule = 0;
+            for (size_t index = 0; index <= catalog_size(); index++)
+            {
+                while (rule < rules_.size() && rules_[rule].index < index)
+                    rule++;
+                first_rule_[index] = rule;
+            }
+            built_ = true;
+        }
+
+        void RuleEngine::evaluate(const MessageInfo &info, long value, uint32_t now, const EventCallback &callback)
+        {
+            if (rules_.empty())
+                return;
+            if (!built_)
+                build();
+
+            size_t index = catalog_index(info);
+            for (size_t rule = first_rule_[index]; rule < first_rule_[index + 1]; rule++)
+                update(rules_[rule], value, now, callback);
+        }
+
+        void RuleEngine::update(Rule &rule, long value, uint32_t now, const EventCallback &callback)
+        {
+            if (rule.condition == RuleCondition::Change)
+            {
+                long previous = rule.value;
+                bool changed = rule.has_value && value != previous;
+                rule.value = value;
+                rule.has_value = true;
+                if (!changed || (rule.has_from && previous != rule.threshold) || (rule.has_to && value != rule.hysteresis))
+                    return;
+
+                events++;
+                callback("events/" + rule.name, "{\"rule\":\"" + rule.name + "\",\"message\":\"" +
+                                                    long_to_hex((uint16_t)catalog_entry(rule.index).messageNumber) +
+                                                    "\",\"from\":" + std::to_string(previous) + ",\"to\":" + std::to_string(value) + "}");
+                return;
+            }
+
+            rule.value = value;
+            bool met, cleared;
+            switch (rule.condition)
+            {
+            case RuleCondition::Above:
+                met = value > rule.threshold;
+                cleared = value <= rule.threshold - rule.hysteresis;
+                break;
+            case RuleCondition::Below:
+                met = value < rule.threshold;
+                cleared = value >= rule.threshold + rule.hysteresis;
+                break;
+            default:
+                met = value == rule.threshold;
+                cleared = !met;
+                break;
+            }
+
+            if (rule.active)
+            {
+                if (cleared)
+                    set_active(rule, false, callback);
+                return;
+            }
+
+            if (!met)
+            {
+                rule.holding = false;
+                return;
+            }
+            if (!rule.holding)
+            {
+                rule.holding = true;
+                rule.since = now;
+            }
+            if (now - rule.since >= rule.duration)
+                set_active(rule, true, callback);
+        }
+
+        void RuleEngine::loop(uint32_t now, const EventCallback &callback)
+        {
+            for (auto &rule : rules_)
+            {
+                if (rule.holding && now - rule.since >= rule.duration)
+                    set_active(rule, true, callback);
+            }
+        }
+
+        void RuleEngine::set_active(Rule &rule, bool active, const EventCallback &callback)
+        {
+            rule.active = active;
+            rule.holding = false;
+            events++;
+            callback("events/" + rule.name, "{\"rule\":\"" + rule.name + "\",\"state\":\"" + (active ? "on" : "off") +
+                                                "\",\"message\":\"" + long_to_hex((uint16_t)catalog_entry(rule.index).messageNumber) +
+                                                "\",\"value\":" + std::to_string(rule.value) + "}");
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
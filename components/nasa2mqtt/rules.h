@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        enum class RuleCondition : uint8_t
+        {
+            // value > threshold, clears at value <= threshold - hysteresis
+            Above = 0,
+            // value < threshold, clears at value >= threshold + hysteresis
+            Below = 1,
+            // value == threshold, clears on any other value
+            Equals = 2,
+            // every change of the value, optionally only from and/or to a given value
+            Change = 3
+        };
+
+        // Alerts evaluated on the device as values are decoded. Rules live in one flat table
+        // sorted by catalog index, so a value only looks at the rules for its own message.
+        // Above, Below and Equals can require the condition to hold for a duration first.
+        class RuleEngine
+        {
+        public:
+            // suffix relative to the topic prefix, JSON payload
+            using EventCallback = std::function<void(const std::string &suffix, const std::string &payload)>;
+
+            void add_rule(const std::string &name, MessageNumber messageNumber, RuleCondition condition,
+                          long threshold, long hysteresis, uint32_t duration);
+            void add_change_rule(const std::string &name, MessageNumber messageNumber,
+                                 bool has_from, long from, bool has_to, long to);
+
+            void evaluate(const MessageInfo &info, long value, uint32_t now, const EventCallback &callback);
+            // Activates rules whose condition has now held for long enough
+            void loop(uint32_t now, const EventCallback &callback);
+
+            uint32_t events = 0;
+
+        private:
+            struct Rule
+            {
+                std::string name;
+                uint16_t index; // catalog index
+                RuleCondition condition;
+                bool has_from = false;
+                bool has_to = false;
+                bool has_value = false;
+                bool holding = false; // condition true, waiting for duration
+                bool active = false;
+                long threshold = 0;   // or from
+                long hysteresis = 0;  // or to
+                uint32_t duration = 0;
+                uint32_t since = 0;
+                long value = 0;       // latest
+            };
+
+            void add(Rule rule, MessageNumber messageNumber);
+            void build();
+            void update(Rule &rule, long value, uint32_t now, const EventCallback &callback);
+            void set_active(Rule &rule, bool active, const EventCallback &callback);
+
+            std::vector<Rule> rules_;
+            std::vector<uint16_t> first_rule_; // by catalog index, one past the end for the last
+            bool built_ = false;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,216 @@
+#include "esphome/core/log.h"
+#include "scheduler.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        static Address destination_for(MessageNumber messageNumber)
+        {
+            // the outdoor unit owns the 0x8xxx range, everything else is answered by the indoor unit
+            return Address::parse(((uint16_t)messageNumber & 0x8000) ? "10.00.00" : "20.00.00");
+        }
+
+        bool RequestScheduler::poll(uint32_t now, uint8_t &packetNumber, std::vector<uint8_t> &frame)
+        {
+            PendingRequest *slot = nullptr;
+            for (auto &pending : pending_)
+            {
+                if (pending.active && now - pending.sent >= REQUEST_TIMEOUT_MS)
+                {
+                    ESP_LOGD(TAG, "Read request %d timed out", pending.packetNumber);
+                    pending.active = false;
+                    timeouts++;
+                }
+                if (!pending.active && slot == nullptr)
+                    slot = &pending;
+            }
+
+            if (messages_.empty() || slot == nullptr)
+                return false;
+
+            if (requests_sent > 0 && now - last_sent_ < REQUEST_SPACING_MS)
+                return false;
+
+            if (cursor_ == 0)
+            {
+                if (cycle_started_ && now - cycle_start_ < interval_)
+                    return false;
+                cycle_started_ = true;
+                cycle_start_ = now;
+            }
+
+            Address da = destination_for(messages_[cursor_]);
+            Packet packet = Packet::create(da, DataType::Read, packetNumber);
+            while (cursor_ < messages_.size() && packet.messages.size() < batch_size_)
+            {
+                if (!(destination_for(messages_[cursor_]) == da))
+                    break;
+
+                MessageSet set(messages_[cursor_]);
+                if (set.type == Structure)
+                {
+                    // structures have to travel alone
+                    if (!packet.messages.empty())
+                        break;
+                    set.structure = {nullptr, 0};
+                    packet.messages.push_back(set);
+                    cursor_++;
+                    break;
+                }
+
+                set.value = 0;
+                packet.messages.push_back(set);
+                cursor_++;
+            }
+            if (cursor_ >= messages_.size())
+                cursor_ = 0;
+
+            frame = packet.encode();
+
+            slot->active = true;
+            slot->packetNumber = packet.pcommand.packetNumber;
+            slot->sent = now;
+            last_sent_ = now;
+            requests_sent++;
+            return true;
+        }
+
+        bool RequestScheduler::handle_response(Packet &packet, uint32_t now)
+        {
+            if (packet.pcommand.dataType != DataType::Response)
+                return false;
+
+            for (auto &pending : pending_)
+            {
+                if (pending.active && pending.packetNumber == packet.pcommand.packetNumber)
+                {
+                    pending.active = false;
+                    round_trip.add(now - pending.sent);
+                    responses++;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::string RequestScheduler::stats_to_json()
+        {
+            std::string json = "{\"sent\":" + std::to_string(requests_sent) +
+                               ",\"responses\":" + std::to_string(responses) +
+                               ",\"timeouts\":" + std::to_string(timeouts) +
+                               ",\"rtt_ms\":" + round_trip.to_json() + "}";
+            round_trip.reset();
+            return json;
+        }
+
+        bool WriteScheduler::enqueue(MessageNumber messageNumber, long value, uint32_t received)
+        {
+            if (allowed_.count(messageNumber) == 0)
+            {
+                ESP_LOGW(TAG, "Write to %s is not allowed", long_to_hex((uint16_t)messageNumber).c_str());
+                return false;
+            }
+
+            commands++;
+
+            // a newer command for the same message replaces one that is still waiting
+            for (auto &command : queue_)
+            {
+                if (!command.inFlight && command.messageNumber == messageNumber)
+                {
+                    command.value = value;
+                    command.received = received;
+                    return true;
+                }
+            }
+
+            if (queue_.size() >= MAX_QUEUED_WRITES)
+            {
+                ESP_LOGW(TAG, "Write queue full, dropping write to %s", long_to_hex((uint16_t)messageNumber).c_str());
+                failures++;
+                return false;
+            }
+
+            queue_.push_back({messageNumber, value, received, false, 0, 0, 0});
+            return true;
+        }
+
+        bool WriteScheduler::poll(uint32_t now, uint8_t &packetNumber, std::vector<uint8_t> &frame)
+        {
+            if (queue_.empty())
+                return false;
+
+            WriteCommand &command = queue_.front();
+            if (command.inFlight)
+            {
+                if (now - command.sent < WRITE_TIMEOUT_MS)
+                    return false;
+
+                if (command.retryCount >= MAX_WRITE_RETRIES)
+                {
+                    ESP_LOGW(TAG, "Write to %s not acknowledged, giving up", long_to_hex((uint16_t)command.messageNumber).c_str());
+                    failures++;
+                    queue_.pop_front();
+                    return false;
+                }
+                command.retryCount++;
+                retries++;
+            }
+
+            // a retry keeps its packet number
+            uint8_t retryNumber = command.packetNumber;
+            Packet packet = Packet::create(destination_for(command.messageNumber), DataType::Write, command.inFlight ? retryNumber : packetNumber);
+            packet.pcommand.retryCount = command.retryCount;
+
+            MessageSet set(command.messageNumber);
+            set.value = command.value;
+            packet.messages.push_back(set);
+
+            frame = packet.encode();
+
+            command.inFlight = true;
+            command.packetNumber = packet.pcommand.packetNumber;
+            command.sent = now;
+            return true;
+        }
+
+        bool WriteScheduler::handle_ack(Packet &packet, uint32_t now)
+        {
+            if (packet.pcommand.dataType != DataType::Ack && packet.pcommand.dataType != DataType::Nack)
+                return false;
+
+            if (queue_.empty() || !queue_.front().inFlight || queue_.front().packetNumber != packet.pcommand.packetNumber)
+                return false;
+
+            WriteCommand &command = queue_.front();
+            if (packet.pcommand.dataType == DataType::Ack)
+            {
+                acks++;
+                command_to_ack.add(now - command.received);
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Write to %s rejected", long_to_hex((uint16_t)command.messageNumber).c_str());
+                nacks++;
+            }
+            queue_.pop_front();
+            return true;
+        }
+
+        std::string WriteScheduler::stats_to_json()
+        {
+            std::string json = "{\"commands\":" + std::to_string(commands) +
+                               ",\"acks\":" + std::to_string(acks) +
+                               ",\"nacks\":" + std::to_string(nacks) +
+                               ",\"retries\":" + std::to_string(retries) +
+                               ",\"failures\":" + std::to_string(failures) +
+                               ",\"latency_ms\":" + command_to_ack.to_json() + "}";
+            command_to_ack.reset();
+            return json;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <set>
+#include "nasa.h"
+#include "util.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Silence on the bus (ms) before we dare to put a frame on it
+        static const uint32_t BUS_IDLE_GAP_MS = 50;
+        // Minimum time between two of our own frames
+        static const uint32_t REQUEST_SPACING_MS = 500;
+        // A request without response after this time counts as lost
+        static const uint32_t REQUEST_TIMEOUT_MS = 2000;
+        // Read requests wait while the units keep the bus busier than this
+        static const float MAX_REQUEST_UTILIZATION = 0.6f;
+        static const uint8_t MAX_PENDING_REQUESTS = 4;
+        // A write without Ack/Nack after this time is sent again
+        static const uint32_t WRITE_TIMEOUT_MS = 300;
+        // retryCount is a 2 bit field in the command
+        static const uint8_t MAX_WRITE_RETRIES = 3;
+        static const size_t MAX_QUEUED_WRITES = 8;
+
+        // Sends DataType::Read requests for message numbers the units don't broadcast on their own.
+        // Every configured message is requested once per interval, batched into as few frames as possible.
+        class RequestScheduler
+        {
+        public:
+            void add_message(uint16_t number)
+            {
+                messages_.push_back((MessageNumber)number);
+            }
+
+            void set_interval(uint32_t interval)
+            {
+                interval_ = interval;
+            }
+
+            void set_batch_size(uint8_t batch_size)
+            {
+                batch_size_ = batch_size;
+            }
+
+            bool enabled()
+            {
+                return !messages_.empty();
+            }
+
+            // Fills frame and returns true when the next request is due. Only call while the bus is idle.
+            bool poll(uint32_t now, uint8_t &packetNumber, std::vector<uint8_t> &frame);
+            // Returns true when the packet answers one of our pending requests
+            bool handle_response(Packet &packet, uint32_t now);
+            // Counters plus round-trip times since the previous call
+            std::string stats_to_json();
+
+            uint32_t requests_sent = 0;
+            uint32_t responses = 0;
+            uint32_t timeouts = 0;
+            LatencyStats round_trip;
+
+        private:
+            struct PendingRequest
+            {
+                bool active = false;
+                uint8_t packetNumber = 0;
+                uint32_t sent = 0;
+            };
+
+            std::vector<MessageNumber> messages_;
+            uint32_t interval_ = 60000;
+            uint8_t batch_size_ = 10;
+
+            size_t cursor_ = 0;
+            bool cycle_started_ = false;
+            uint32_t cycle_start_ = 0;
+            uint32_t last_sent_ = 0;
+            PendingRequest pending_[MAX_PENDING_REQUESTS];
+        };
+
+        // Sends DataType::Write packets for commands received via MQTT, one at a time,
+        // and resends them with an increasing retryCount until they are acknowledged.
+        class WriteScheduler
+        {
+        public:
+            void allow_message(uint16_t number)
+            {
+                allowed_.insert((MessageNumber)number);
+            }
+
+            bool enabled()
+            {
+                return !allowed_.empty();
+            }
+
+            // received is the time the command arrived, for command-to-ack latency
+            bool enqueue(MessageNumber messageNumber, long value, uint32_t received);
+            // Fills frame and returns true when a write (or its retry) is due. Only call while the bus is idle.
+            bool poll(uint32_t now, uint8_t &packetNumber, std::vector<uint8_t> &frame);
+            // Returns true when the packet acknowledges the write in flight
+            bool handle_ack(Packet &packet, uint32_t now);
+            std::string stats_to_json();
+
+            uint32_t commands = 0;
+            uint32_t acks = 0;
+            uint32_t nacks = 0;
+            uint32_t retries = 0;
+            uint32_t failures = 0;
+            LatencyStats command_to_ack;
+
+        private:
+            struct WriteCommand
+            {
+                MessageNumber messageNumber;
+                long value;
+                uint32_t received;
+                bool inFlight;
+                uint8_t retryCount;
+                uint8_t packetNumber;
+                uint32_t sent;
+            };
+
+            std::set<MessageNumber> allowed_;
+            std::deque<WriteCommand> queue_; // front is the one in flight
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include "sequence.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        SequenceTracker::Source *SequenceTracker::find(Address &sa)
+        {
+            for (auto &source : sources_)
+            {
+                if (source.address == sa)
+                    return &source;
+            }
+            if (sources_.size() >= MAX_TRACKED_SOURCES)
+                return nullptr;
+
+            sources_.emplace_back();
+            sources_.back().address = sa;
+            return &sources_.back();
+        }
+
+        bool SequenceTracker::accept(Address &sa, const Command &command, uint32_t now)
+        {
+            Source *source = find(sa);
+            if (source == nullptr)
+                return true;
+
+            if (source->frames > 0 && source->last_type == command.dataType && source->last_number == command.packetNumber &&
+                now - source->last_seen < DUPLICATE_WINDOW_MS)
+            {
+                source->duplicates++;
+                duplicates++;
+                return false;
+            }
+
+            source->frames++;
+            source->last_type = command.dataType;
+            source->last_number = command.packetNumber;
+            source->last_seen = now;
+
+            switch (command.dataType)
+            {
+            case DataType::Read:
+            case DataType::Write:
+            case DataType::Request:
+            case DataType::Notification:
+                break;
+            default:
+                return true;
+            }
+
+            if (source->numbered)
+            {
+                uint8_t gap = command.packetNumber - source->next_number;
+                if (gap > 0 && gap <= MAX_PACKET_GAP)
+                {
+                    source->lost += gap;
+                    lost += gap;
+                }
+            }
+            source->numbered = true;
+            source->next_number = command.packetNumber + 1;
+            return true;
+        }
+
+        std::string SequenceTracker::stats_to_json()
+        {
+            std::string json = "{";
+            for (auto &source : sources_)
+            {
+                char loss[16];
+                snprintf(loss, sizeof(loss), "%.4f", source.lost == 0 ? 0.0 : (double)source.lost / (source.frames + source.lost));
+                if (json.length() > 1)
+                    json += ",";
+                json += "\"" + source.address.to_string() + "\":{";
+                json += "\"frames\":" + std::to_string(source.frames) + ",";
+                json += "\"lost\":" + std::to_string(source.lost) + ",";
+                json += "\"duplicates\":" + std::to_string(source.duplicates) + ",";
+                json += "\"loss\":" + std::string(loss) + "}";
+            }
+            json += "}";
+            return json;
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
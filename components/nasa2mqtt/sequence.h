@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // Same source, type and packet number within this window: a retransmission
+        static const uint32_t DUPLICATE_WINDOW_MS = 1000;
+        // Bigger jumps in the packet numbers are a restart or a long silence, not loss
+        static const uint8_t MAX_PACKET_GAP = 16;
+        static const size_t MAX_TRACKED_SOURCES = 32;
+
+        // Packet numbers per source device. Frames a device sends on its own (notifications,
+        // requests, writes) count up by one; responses and acks echo the number of the request,
+        // so they are only checked for retransmission.
+        class SequenceTracker
+        {
+        public:
+            // false for a retransmission of a frame that was already processed
+            bool accept(Address &sa, const Command &command, uint32_t now);
+
+            // {"<address>":{"frames":..,"lost":..,"duplicates":..,"loss":<lost/(frames+lost)>},..}
+            std::string stats_to_json();
+
+            // totals over all sources
+            uint32_t lost = 0;
+            uint32_t duplicates = 0;
+
+        private:
+            struct Source
+            {
+                Address address;
+                bool numbered = false;
+                uint8_t next_number = 0;
+                DataType last_type = DataType::Undefined;
+                uint8_t last_number = 0;
+                uint32_t last_seen = 0;
+                uint32_t frames = 0;
+                uint32_t lost = 0;
+                uint32_t duplicates = 0;
+            };
+
+            Source *find(Address &sa);
+
+            std::vector<Source> sources_;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdio>
+#include "esphome/core/log.h"
+#include "state.h"
+
+static const char *TAG = "NASA2MQTT";
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        void StateDocuments::setup(uint32_t interval, uint32_t delta_interval)
+        {
+            interval_ = interval;
+            delta_interval_ = delta_interval;
+        }
+
+        void StateDocuments::update(const MessageInfo &info, const Address &source, int32_t value, uint32_t now)
+        {
+            size_t device = 0;
+            while (device < devices_.size() && !(devices_[device].address == source))
+                device++;
+            if (device == devices_.size())
+            {
+                if (devices_.size() == MAX_DEVICES)
+                    return;
+                // the first document waits a delta interval for the values of the first few frames
+                devices_.push_back({source, {}, "", "", now - interval_ + delta_interval_, now, false});
+                ESP_LOGD(TAG, "State documents: new device %s", devices_.back().address.to_string().c_str());
+            }
+
+            Device &state = devices_[device];
+            const uint16_t index = catalog_index(info);
+            auto field = std::lower_bound(state.fields.begin(), state.fields.end(), index, [](const Field &field, uint16_t index)
+                                          { return field.index < index; });
+            if (field == state.fields.end() || field->index != index)
+                state.fields.insert(field, {index, true, value});
+            else if (field->value != value)
+            {
+                field->value = value;
+                field->changed = true;
+            }
+            else
+                return;
+            state.dirty = true;
+        }
+
+        void StateDocuments::loop(uint32_t now, const std::string &topic_prefix, const PublishCallback &callback)
+        {
+            for (auto &device : devices_)
+            {
+                if (device.state_topic.empty())
+                {
+                    const std::string topic = topic_prefix + "/device/" + device.address.to_string();
+                    device.state_topic = topic + "/state";
+                    device.delta_topic = topic + "/delta";
+                }
+
+                if (now - device.last_document >= interval_)
+                {
+                    serialize(device, false);
+                    if (!callback(device.state_topic, buffer_, true))
+                        continue;
+                    documents++;
+                    document_bytes_ += buffer_.length();
+                    device.last_document = now;
+                    device.last_delta = now;
+                    device.dirty = false;
+                    for (auto &field : device.fields)
+                        field.changed = false;
+                }
+                else if (device.dirty && now - device.last_delta >= delta_interval_)
+                {
+                    serialize(device, true);
+                    if (!callback(device.delta_topic, buffer_, false))
+                        continue;
+                    deltas++;
+                    delta_bytes_ += buffer_.length();
+                    device.last_delta = now;
+                    device.dirty = false;
+                }
+            }
+        }
+
+        void StateDocuments::serialize(const Device &device, bool changed_only)
+        {
+            buffer_.assign(1, '{');
+            char field[24];
+            for (auto &entry : device.fields)
+            {
+                if (changed_only && !entry.changed)
+                    continue;
+                // keys as in the state topics
+                int length = snprintf(field, sizeof(field), "%s\"%02x\":%ld", buffer_.length() > 1 ? "," : "",
+                                      (uint16_t)catalog_entry(entry.index).messageNumber, (long)entry.value);
+                buffer_.append(field, length);
+            }
+            buffer_.push_back('}');
+        }
+
+        std::string StateDocuments::stats_to_json()
+        {
+            return "{\"devices\":" + std::to_string(devices_.size()) +
+                   ",\"documents\":" + std::to_string(documents) +
+                   ",\"document_avg_bytes\":" + std::to_string(documents > 0 ? document_bytes_ / documents : 0) +
+                   ",\"deltas\":" + std::to_string(deltas) +
+                   ",\"delta_avg_bytes\":" + std::to_string(deltas > 0 ? delta_bytes_ / deltas : 0) + "}";
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
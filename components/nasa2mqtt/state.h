@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "catalog.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // One retained JSON document per device with the latest value of every message it sent,
+        // {"<hex message>":<raw value>,...} on <prefix>/device/<address>/state, so a new subscriber
+        // gets the whole state in one message. In between, <prefix>/device/<address>/delta carries
+        // the values changed since that document, in the same form: a lost delta is made up for by
+        // the next one. Keys are those of the state topics, values are raw like there.
+        class StateDocuments
+        {
+        public:
+            // topic, payload and retain; false when it could not be sent and should be retried
+            using PublishCallback = std::function<bool(const std::string &topic, const std::string &payload, bool retain)>;
+
+            // A document every interval ms, a delta at most every delta_interval ms; nothing without
+            void setup(uint32_t interval, uint32_t delta_interval);
+            bool enabled()
+            {
+                return interval_ > 0;
+            }
+
+            void update(const MessageInfo &info, const Address &source, int32_t value, uint32_t now);
+            // Sends the documents and deltas that are due. topic_prefix is the publisher's.
+            void loop(uint32_t now, const std::string &topic_prefix, const PublishCallback &callback);
+
+            std::string stats_to_json();
+
+            uint32_t documents = 0;
+            uint32_t deltas = 0;
+
+        private:
+            struct Field
+            {
+                uint16_t index; // catalog index
+                bool changed;   // since the last document
+                int32_t value;
+            };
+
+            struct Device
+            {
+                Address address;
+                // sorted by index, grows as messages first arrive
+                std::vector<Field> fields;
+                std::string state_topic;
+                std::string delta_topic;
+                uint32_t last_document;
+                uint32_t last_delta;
+                bool dirty; // changed since the last document or delta
+            };
+
+            static const size_t MAX_DEVICES = 16;
+
+            // JSON object of the (changed) fields into buffer_
+            void serialize(const Device &device, bool changed_only);
+
+            uint32_t interval_ = 0;
+            uint32_t delta_interval_ = 0;
+            std::vector<Device> devices_;
+            // reused for every document, so serializing does not allocate once it has the largest
+            std::string buffer_;
+            uint64_t document_bytes_ = 0;
+            uint64_t delta_bytes_ = 0;
+        };
+
+    } // namespace nasa2mqtt
+} // namespace esphome
@@ -0,0 +1,52 @@
+#include "structure.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // NUL padded ASCII
+        static const MessageNumber TEXT_STRUCTURES[] = {
+            MessageNumber::STR_AD_ID_SERIAL_NUMBER_607,
+            MessageNumber::STR_AD_ID_MODEL_NAME_61F,
+        };
+
+        static std::string structure_to_text(const StructureView &structure)
+        {
+            std::string text;
+            text.reserve(structure.size);
+            for (uint16_t i = 0; i < structure.size && structure.data[i] != 0; i++)
+            {
+                char c = (char)structure.data[i];
+                text += c >= 0x20 && c < 0x7F ? c : '?';
+            }
+            while (!text.empty() && text.back() == ' ')
+                text.pop_back();
+            return text;
+        }
+
+        static std::string structure_to_json(const StructureView &structure)
+        {
+            static const char *const DIGITS = "0123456789abcdef";
+            std::string json = "{\"length\":" + std::to_string(structure.size) + ",\"hex\":\"";
+            json.reserve(json.size() + structure.size * 2 + 2);
+            for (uint16_t i = 0; i < structure.size; i++)
+            {
+                json += DIGITS[structure.data[i] >> 4];
+                json += DIGITS[structure.data[i] & 0x0F];
+            }
+            json += "\"}";
+            return json;
+        }
+
+        std::string structure_to_payload(MessageNumber messageNumber, const StructureView &structure)
+        {
+            for (MessageNumber text : TEXT_STRUCTURES)
+            {
+                if (text == messageNumber)
+                    return structure_to_text(structure);
+            }
+            return structure_to_json(structure);
+        }
+
+    } // namespace nasa2mqtt
+} // namespace esphome
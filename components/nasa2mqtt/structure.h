@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include "nasa.h"
+
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        // MQTT payload of a structure message: the known string messages (model name, serial number)
+        // as plain text, anything else as {"length":<bytes>,"hex":"<payload>"}
+        std::string structure_to_payload(MessageNumber messageNumber, const StructureView &structure);
+
+    } // namespace nasa2mqtt
+} // namespace esphome
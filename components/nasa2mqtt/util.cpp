@@ -40,5 +40,31 @@ namespace esphome
         {
             std::cout << std::bitset<8>(value) << std::endl;
         }
+
+        void LatencyStats::add(uint32_t value)
+        {
+            if (count == 0 || value < min)
+                min = value;
+            if (value > max)
+                max = value;
+            total += value;
+            count++;
+        }
+
+        void LatencyStats::reset()
+        {
+            count = 0;
+            min = 0;
+            max = 0;
+            total = 0;
+        }
+
+        std::string LatencyStats::to_json()
+        {
+            char str[80];
+            sprintf(str, "{\"count\":%u,\"min\":%u,\"max\":%u,\"avg\":%u}", (unsigned)count, (unsigned)min,
+                    (unsigned)max, count == 0 ? 0u : (unsigned)(total / count));
+            return str;
+        }
     } // namespace nasa2mqtt
 } // namespace esphome
@@ -14,5 +14,18 @@ namespace esphome
         std::string bytes_to_hex(const std::vector<uint8_t> &data);
         std::vector<uint8_t> hex_to_bytes(const std::string &hex);
         void print_bits_8(uint8_t value);
+
+        // Running min/max/average over a reporting window, e.g. round-trip times
+        struct LatencyStats
+        {
+            uint32_t count = 0;
+            uint32_t min = 0;
+            uint32_t max = 0;
+            uint64_t total = 0;
+
+            void add(uint32_t value);
+            void reset();
+            std::string to_json();
+        };
     } // namespace nasa2mqtt
 } // namespace esphome
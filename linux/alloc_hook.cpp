@@ -0,0 +1,65 @@
+// Counts every operator new of the process into heap_allocations, for the footprint metrics of the
+// daemon and the allocation check in linux/tools. Nothing in here is built for the ESP.
+
+#include <cstdlib>
+#include <new>
+#include "footprint.h"
+
+using esphome::nasa2mqtt::heap_allocations;
+
+static void *counted_alloc(size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size == 0 ? 1 : size);
+}
+
+static struct AllocationCounting
+{
+    AllocationCounting()
+    {
+        esphome::nasa2mqtt::heap_allocations_counted = true;
+    }
+} allocation_counting;
+
+void *operator new(size_t size)
+{
+    void *p = counted_alloc(size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,96 @@
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome
+{
+    int log_level = LOG_LEVEL_INFO;
+
+    void log_printf(int level, const char *tag, const char *format, ...)
+    {
+        static const char *const LEVELS = "?EWICDV";
+        fprintf(stderr, "[%c][%s] ", LEVELS[level], tag);
+        va_list args;
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+        fputc('\n', stderr);
+    }
+
+    static uint64_t monotonic_us()
+    {
+        static uint64_t start = 0;
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t now = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        if (start == 0)
+            start = now;
+        return now - start + 1;
+    }
+
+    uint32_t millis()
+    {
+        return (uint32_t)(monotonic_us() / 1000);
+    }
+
+    uint32_t micros()
+    {
+        return (uint32_t)monotonic_us();
+    }
+
+    uint32_t fnv1_hash(const std::string &str)
+    {
+        uint32_t hash = 2166136261UL;
+        for (char c : str)
+        {
+            hash *= 16777619UL;
+            hash ^= (uint8_t)c;
+        }
+        return hash;
+    }
+
+    static ESPPreferences preferences;
+    ESPPreferences *global_preferences = &preferences;
+
+    ESPPreferenceObject ESPPreferences::make_preference(uint32_t type)
+    {
+        if (directory.empty())
+            return ESPPreferenceObject();
+
+        char name[16];
+        snprintf(name, sizeof(name), "/%08x.pref", type);
+        return ESPPreferenceObject(directory + name);
+    }
+
+    bool ESPPreferenceObject::save_raw(const void *data, size_t size)
+    {
+        if (path_.empty())
+            return false;
+
+        // write and rename, so a crash never leaves half a file behind
+        std::string temp = path_ + ".tmp";
+        FILE *file = fopen(temp.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        bool ok = fwrite(data, 1, size, file) == size;
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temp.c_str(), path_.c_str()) == 0;
+    }
+
+    bool ESPPreferenceObject::load_raw(void *data, size_t size)
+    {
+        if (path_.empty())
+            return false;
+
+        FILE *file = fopen(path_.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+        bool ok = fread(data, 1, size, file) == size && fgetc(file) == EOF;
+        fclose(file);
+        return ok;
+    }
+} // namespace esphome
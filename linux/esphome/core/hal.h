@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome
+{
+    // monotonic, since daemon start
+    uint32_t millis();
+    uint32_t micros();
+} // namespace esphome
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome
+{
+    uint32_t fnv1_hash(const std::string &str);
+} // namespace esphome
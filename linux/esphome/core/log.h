@@ -0,0 +1,33 @@
+#pragma once
+
+// Minimal stand-in for the ESPHome logger, so the component sources build into the Linux daemon
+namespace esphome
+{
+    enum LogLevel
+    {
+        LOG_LEVEL_NONE = 0,
+        LOG_LEVEL_ERROR = 1,
+        LOG_LEVEL_WARN = 2,
+        LOG_LEVEL_INFO = 3,
+        LOG_LEVEL_CONFIG = 4,
+        LOG_LEVEL_DEBUG = 5,
+        LOG_LEVEL_VERBOSE = 6
+    };
+
+    extern int log_level;
+    void log_printf(int level, const char *tag, const char *format, ...);
+} // namespace esphome
+
+#define ESP_LOG_AT(level, tag, ...)                                 \
+    do                                                              \
+    {                                                               \
+        if (::esphome::log_level >= level)                          \
+            ::esphome::log_printf(level, tag, __VA_ARGS__);         \
+    } while (0)
+
+#define ESP_LOGE(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_AT(::esphome::LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
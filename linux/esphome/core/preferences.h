@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace esphome
+{
+    // File backed preferences: one file per preference in the state directory
+    class ESPPreferenceObject
+    {
+    public:
+        ESPPreferenceObject() = default;
+        explicit ESPPreferenceObject(const std::string &path) : path_(path) {}
+
+        template <typename T>
+        bool save(const T *src)
+        {
+            return save_raw(src, sizeof(T));
+        }
+
+        template <typename T>
+        bool load(T *dest)
+        {
+            return load_raw(dest, sizeof(T));
+        }
+
+    private:
+        bool save_raw(const void *data, size_t size);
+        bool load_raw(void *data, size_t size);
+
+        std::string path_;
+    };
+
+    class ESPPreferences
+    {
+    public:
+        template <typename T>
+        ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false)
+        {
+            return make_preference(type);
+        }
+
+        ESPPreferenceObject make_preference(uint32_t type);
+
+        // empty: nothing is persisted
+        std::string directory;
+    };
+
+    extern ESPPreferences *global_preferences;
+} // namespace esphome
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Anything the daemon's epoll loop waits on; epoll_event.data.ptr points to one
+class EventHandler
+{
+public:
+    virtual ~EventHandler() = default;
+    virtual void handle_event(uint32_t events) = 0;
+};
@@ -0,0 +1,179 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esphome/core/log.h"
+#include "metrics_server.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+static const char *TAG = "metrics";
+
+// a scrape request is one short line plus a few headers
+static const size_t MAX_REQUEST = 2048;
+
+bool MetricsServer::listen(int epfd, uint16_t port, const std::string &path)
+{
+    epfd_ = epfd;
+    path_ = path;
+
+    fd_ = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+        return false;
+
+    int on = 1;
+    int off = 0;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd_, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    sockaddr_in6 address = {};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(fd_, (sockaddr *)&address, sizeof(address)) != 0 || ::listen(fd_, 8) != 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = static_cast<EventHandler *>(this);
+    epoll_ctl(epfd_, EPOLL_CTL_ADD, fd_, &event);
+    ESP_LOGI(TAG, "Serving http://*:%u%s", port, path_.c_str());
+    return true;
+}
+
+void MetricsServer::handle_event(uint32_t events)
+{
+    while (true)
+    {
+        int fd = accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        if (connections_.size() >= MAX_CONNECTIONS)
+        {
+            ESP_LOGW(TAG, "Too many scrapers, refusing one");
+            ::close(fd);
+            continue;
+        }
+
+        connections_.emplace_back(new Connection(*this, fd));
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = static_cast<EventHandler *>(connections_.back().get());
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void MetricsServer::close(Connection *connection)
+{
+    for (auto it = connections_.begin(); it != connections_.end(); ++it)
+    {
+        if (it->get() == connection)
+        {
+            connections_.erase(it);
+            return;
+        }
+    }
+}
+
+MetricsServer::Connection::~Connection()
+{
+    // closing also removes it from epoll
+    ::close(fd_);
+}
+
+void MetricsServer::Connection::handle_event(uint32_t events)
+{
+    bool open = true;
+    if (!responding_ && (events & EPOLLIN))
+    {
+        open = read_request();
+        if (open && responding_)
+        {
+            epoll_event event = {};
+            event.events = EPOLLOUT;
+            event.data.ptr = static_cast<EventHandler *>(this);
+            epoll_ctl(server_.epfd_, EPOLL_CTL_MOD, fd_, &event);
+        }
+    }
+    if (open && responding_ && (events & EPOLLOUT))
+        open = write_response();
+    if (events & (EPOLLERR | EPOLLHUP))
+        open = false;
+
+    if (!open)
+        server_.close(this); // deletes this
+}
+
+bool MetricsServer::Connection::read_request()
+{
+    char buffer[512];
+    while (true)
+    {
+        ssize_t n = read(fd_, buffer, sizeof(buffer));
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        if (n == 0)
+            return false;
+
+        request_.append(buffer, n);
+        if (request_.find("\r\n\r\n") != std::string::npos)
+        {
+            respond();
+            return true;
+        }
+        if (request_.size() > MAX_REQUEST)
+            return false;
+    }
+}
+
+void MetricsServer::Connection::respond()
+{
+    int length;
+    const std::string line = request_.substr(0, request_.find("\r\n"));
+    if (line == "GET " + server_.path_ + " HTTP/1.0" || line == "GET " + server_.path_ + " HTTP/1.1")
+    {
+        renderer_.reset(new MetricsRenderer());
+        length = snprintf(buffer_, sizeof(buffer_),
+                          "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                          "Connection: close\r\n\r\n");
+    }
+    else
+    {
+        length = snprintf(buffer_, sizeof(buffer_), "HTTP/1.0 404 Not Found\r\nConnection: close\r\n\r\n");
+    }
+
+    request_.clear();
+    length_ = length;
+    offset_ = 0;
+    responding_ = true;
+}
+
+bool MetricsServer::Connection::write_response()
+{
+    while (true)
+    {
+        if (offset_ == length_)
+        {
+            length_ = renderer_ ? renderer_->render(buffer_, sizeof(buffer_)) : 0;
+            offset_ = 0;
+            if (length_ == 0)
+                return false;
+        }
+
+        ssize_t n = send(fd_, buffer_ + offset_, length_ - offset_, MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        offset_ += n;
+    }
+}
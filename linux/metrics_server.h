@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "event.h"
+#include "metrics.h"
+
+// Plain HTTP/1.0 scrape endpoint, one response per connection. Sockets are non-blocking
+// and responses are rendered into a fixed buffer as the client drains them, so a slow
+// scraper never holds up the serial ports.
+class MetricsServer : public EventHandler
+{
+public:
+    bool listen(int epfd, uint16_t port, const std::string &path);
+    void handle_event(uint32_t events) override;
+
+private:
+    static const size_t MAX_CONNECTIONS = 8;
+
+    class Connection : public EventHandler
+    {
+    public:
+        Connection(MetricsServer &server, int fd) : server_(server), fd_(fd) {}
+        ~Connection();
+
+        void handle_event(uint32_t events) override;
+
+    private:
+        // false once the request is complete
+        bool read_request();
+        void respond();
+        // false when done or broken
+        bool write_response();
+
+        MetricsServer &server_;
+        int fd_;
+        std::string request_;
+        std::unique_ptr<esphome::nasa2mqtt::MetricsRenderer> renderer_;
+        char buffer_[1024];
+        size_t length_ = 0;
+        size_t offset_ = 0;
+        bool responding_ = false;
+    };
+
+    void close(Connection *connection);
+
+    int epfd_ = -1;
+    int fd_ = -1;
+    std::string path_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+};
@@ -0,0 +1,475 @@
+// nasa2mqttd: the nasa2mqtt gateway as a native Linux daemon.
+//
+// One epoll loop waits on every serial port and on the broker socket, so a
+// gateway with several buses needs neither threads nor busy polling. Frames go
+// through the same FrameAssembler / process_message / Publisher path as on the ESP.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
+#include "event.h"
+#include "metrics_server.h"
+#include "mqtt.h"
+#include "nasa.h"
+#include "protocol.h"
+#include "publisher.h"
+#include "sequence.h"
+#include "dedup.h"
+#include "analyzer.h"
+#include "footprint.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+static const char *TAG = "nasa2mqttd";
+
+// Upper bound for one epoll_wait, so publisher timers and stats keep running on a quiet bus
+static const int MAX_WAIT_MS = 100;
+
+struct Bus : public MessageTarget, public EventHandler
+{
+    std::string device;
+    int fd = -1;
+    int epfd = -1;
+    FrameAssembler framer;
+    Packet packet_;
+    Publisher publisher_;
+    SequenceTracker sequence_tracker_;
+    FrameDedup frame_dedup_;
+    BusAnalyzer analyzer;
+    std::set<std::string> addresses;
+
+    void register_address(const std::string address) override
+    {
+        addresses.insert(address);
+    }
+
+    void handle_packet(Packet &packet) override
+    {
+        // Monitoring only: the daemon sends no requests or writes, so there is nothing to match
+    }
+
+    Publisher &publisher() override
+    {
+        return publisher_;
+    }
+
+    Packet &packet() override
+    {
+        return packet_;
+    }
+
+    SequenceTracker &sequence_tracker() override
+    {
+        return sequence_tracker_;
+    }
+
+    FrameDedup &frame_dedup() override
+    {
+        return frame_dedup_;
+    }
+
+    void handle_event(uint32_t events) override
+    {
+        read();
+        if (events & (EPOLLERR | EPOLLHUP))
+        {
+            // adapter unplugged: stop polling it instead of spinning on the hangup
+            ESP_LOGE(TAG, "%s: device lost", device.c_str());
+            epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    // Drains the port into the frame assembler
+    void read();
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int)
+{
+    running = 0;
+}
+
+// NASA runs at 9600 baud 8E1
+static int open_serial(const std::string &device)
+{
+    int fd = open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, B9600);
+    cfsetospeed(&tty, B9600);
+    tty.c_cflag &= ~(CSTOPB | PARODD | CSIZE | CRTSCTS);
+    tty.c_cflag |= CS8 | PARENB | CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tty) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return fd;
+}
+
+void Bus::read()
+{
+    uint8_t buffer[256];
+    while (true)
+    {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        // with VMIN = VTIME = 0 an empty tty reads 0 rather than EAGAIN
+        if (n <= 0)
+        {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                ESP_LOGW(TAG, "%s: read failed: %s", device.c_str(), strerror(errno));
+            return;
+        }
+
+        const uint32_t now = millis();
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (framer.push(buffer[i], now))
+            {
+                analyzer.add_frame(framer.data(), framer.frame_start(), framer.last_byte());
+                footprint.frame_begin();
+                process_message(framer.data(), this);
+                footprint.frame_end();
+            }
+        }
+    }
+}
+
+static void log_addresses(const Bus &bus)
+{
+    std::string known;
+    for (auto const &address : bus.addresses)
+        known += known.length() > 0 ? ", " + address : address;
+    ESP_LOGCONFIG(TAG, "%s: discovered devices: %s", bus.device.c_str(), known.length() == 0 ? "-" : known.c_str());
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options] <serial device>[=<topic prefix>]...\n"
+            "  --mqtt-host <host>        broker host (default localhost)\n"
+            "  --mqtt-port <port>        broker port (default 1883)\n"
+            "  --mqtt-username <user>\n"
+            "  --mqtt-password <password>\n"
+            "  --mqtt-ca-file <file>     connect over TLS, trusting this CA; reconnects resume the session\n"
+            "  --mqtt-client-id <id>     (default random)\n"
+            "  --mqtt-persistent-session keep subscriptions and QoS 1 messages on the broker across\n"
+            "                            reconnects, needs --mqtt-client-id\n"
+            "  --mqtt-inflight <n>       QoS 1 messages awaiting their PUBACK at once, 1 to 32 (default 8)\n"
+            "  --state-dir <directory>   persist energy counters and filters here\n"
+            "  --update-interval <ms>    stats and reconnect interval (default 30000)\n"
+            "  --metrics-port <port>     serve OpenMetrics over HTTP on this port\n"
+            "  --metrics-path <path>     (default /metrics)\n"
+            "  --history <hex>[:<bytes>[:<s>]]  keep a compressed history of this message on every bus,\n"
+            "                            at most one sample per s (default 1024 bytes, 60 s)\n"
+            "  --discovery-prefix <prefix>  announce messages to Home Assistant under this prefix\n"
+            "  --state-documents <s>[:<s>]  retained state document per device every s (default 60),\n"
+            "                            deltas in between at most every s (default 5)\n"
+            "  --frame-dedup <s>         skip notifications identical to the last of their kind, but\n"
+            "                            let one through every s\n"
+            "  --verbose                 debug logging, twice for verbose\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    std::string host = "localhost";
+    uint16_t port = 1883;
+    std::string username;
+    std::string password;
+    std::string ca_file;
+    std::string client_id;
+    bool persistent_session = false;
+    int inflight_window = 8;
+    uint32_t update_interval = 30000;
+    uint16_t metrics_port = 0;
+    std::string metrics_path = "/metrics";
+    // message, bytes, interval in s
+    std::vector<std::tuple<MessageNumber, size_t, uint32_t>> history;
+    std::string discovery_prefix;
+    // ms, 0 without state documents
+    uint32_t state_interval = 0;
+    uint32_t state_delta_interval = 0;
+    // ms, 0 decodes every frame
+    uint32_t dedup_max_age = 0;
+    std::vector<std::unique_ptr<Bus>> buses;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--mqtt-host" && has_value)
+            host = argv[++i];
+        else if (arg == "--mqtt-port" && has_value)
+            port = (uint16_t)atoi(argv[++i]);
+        else if (arg == "--mqtt-username" && has_value)
+            username = argv[++i];
+        else if (arg == "--mqtt-password" && has_value)
+            password = argv[++i];
+        else if (arg == "--mqtt-ca-file" && has_value)
+            ca_file = argv[++i];
+        else if (arg == "--mqtt-client-id" && has_value)
+            client_id = argv[++i];
+        else if (arg == "--mqtt-persistent-session")
+            persistent_session = true;
+        else if (arg == "--mqtt-inflight" && has_value)
+            inflight_window = atoi(argv[++i]);
+        else if (arg == "--state-dir" && has_value)
+            global_preferences->directory = argv[++i];
+        else if (arg == "--update-interval" && has_value)
+            update_interval = (uint32_t)atoi(argv[++i]);
+        else if (arg == "--metrics-port" && has_value)
+            metrics_port = (uint16_t)atoi(argv[++i]);
+        else if (arg == "--metrics-path" && has_value)
+            metrics_path = argv[++i];
+        else if (arg == "--history" && has_value)
+        {
+            unsigned int number = 0, bytes = 1024, interval = 60;
+            if (sscanf(argv[++i], "%x:%u:%u", &number, &bytes, &interval) < 1)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            history.emplace_back((MessageNumber)number, bytes, interval);
+        }
+        else if (arg == "--discovery-prefix" && has_value)
+            discovery_prefix = argv[++i];
+        else if (arg == "--state-documents" && has_value)
+        {
+            unsigned int interval = 60, delta_interval = 5;
+            if (sscanf(argv[++i], "%u:%u", &interval, &delta_interval) < 1 || interval == 0 || delta_interval == 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            state_interval = interval * 1000;
+            state_delta_interval = delta_interval * 1000;
+        }
+        else if (arg == "--frame-dedup" && has_value)
+            dedup_max_age = (uint32_t)atoi(argv[++i]) * 1000;
+        else if (arg == "--verbose")
+            log_level = log_level < LOG_LEVEL_DEBUG ? LOG_LEVEL_DEBUG : LOG_LEVEL_VERBOSE;
+        else if (arg.rfind("--", 0) == 0)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+        {
+            auto bus = std::unique_ptr<Bus>(new Bus());
+            size_t eq = arg.find('=');
+            bus->device = arg.substr(0, eq);
+            if (eq != std::string::npos)
+                bus->publisher_.topic_prefix = arg.substr(eq + 1);
+            buses.push_back(std::move(bus));
+        }
+    }
+
+    if (buses.empty() || (persistent_session && client_id.empty()) || inflight_window < 1 || inflight_window > 32)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+    {
+        ESP_LOGE(TAG, "epoll_create1: %s", strerror(errno));
+        return 1;
+    }
+
+    for (auto &bus : buses)
+    {
+        bus->fd = open_serial(bus->device);
+        if (bus->fd < 0)
+        {
+            ESP_LOGE(TAG, "%s: %s", bus->device.c_str(), strerror(errno));
+            return 1;
+        }
+
+        bus->epfd = epfd;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = static_cast<EventHandler *>(bus.get());
+        epoll_ctl(epfd, EPOLL_CTL_ADD, bus->fd, &event);
+
+        bus->publisher_.derived.setup(bus->publisher_.topic_prefix);
+        bus->publisher_.filter.setup(bus->publisher_.topic_prefix);
+        mqtt_subscribe(bus->publisher_.topic("nasa2mqtt/filter"));
+        for (auto &series : history)
+            bus->publisher_.history.add_series(std::get<0>(series), std::get<1>(series), std::get<2>(series));
+        if (bus->publisher_.history.enabled())
+            mqtt_subscribe(bus->publisher_.topic("nasa2mqtt/history/get"));
+        if (!discovery_prefix.empty())
+            bus->publisher_.discovery.setup(discovery_prefix, 1000, 5);
+        if (state_interval > 0)
+            bus->publisher_.states.setup(state_interval, state_delta_interval);
+        bus->frame_dedup_.setup(dedup_max_age);
+        bus->publisher_.metrics.bus = bus->publisher_.topic_prefix;
+        register_metrics(&bus->publisher_.metrics);
+        ESP_LOGI(TAG, "%s: publishing to %s/", bus->device.c_str(), bus->publisher_.topic_prefix.c_str());
+    }
+
+    MetricsServer metrics;
+    if (metrics_port != 0 && !metrics.listen(epfd, metrics_port, metrics_path))
+    {
+        ESP_LOGE(TAG, "metrics port %u: %s", metrics_port, strerror(errno));
+        return 1;
+    }
+
+    mqtt_set_tls(ca_file);
+    mqtt_set_session(client_id, !persistent_session);
+    // libmosquitto resends unacknowledged messages on a reconnect, there is no timeout to set
+    mqtt_set_inflight(inflight_window, 0);
+    mqtt_connect(host, port, username, password);
+    uint32_t last_update = millis();
+
+    // The broker socket changes on every reconnect; data.ptr == nullptr marks it
+    int registered_socket = -1;
+    uint32_t registered_events = 0;
+
+    epoll_event events[16];
+    while (running)
+    {
+        int socket = mqtt_socket();
+        uint32_t wanted = EPOLLIN | (mqtt_want_write() ? EPOLLOUT : 0);
+        if (socket != registered_socket || wanted != registered_events)
+        {
+            if (registered_socket >= 0 && socket != registered_socket)
+                epoll_ctl(epfd, EPOLL_CTL_DEL, registered_socket, nullptr);
+            if (socket >= 0)
+            {
+                epoll_event event = {};
+                event.events = wanted;
+                event.data.ptr = nullptr;
+                // a reconnect may hand out the same descriptor number, already dropped by epoll on close
+                if (socket != registered_socket || epoll_ctl(epfd, EPOLL_CTL_MOD, socket, &event) != 0)
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, socket, &event);
+            }
+            registered_socket = socket;
+            registered_events = wanted;
+        }
+
+        int count = epoll_wait(epfd, events, 16, MAX_WAIT_MS);
+        if (count < 0 && errno != EINTR)
+        {
+            ESP_LOGE(TAG, "epoll_wait: %s", strerror(errno));
+            break;
+        }
+
+        bool mqtt_readable = false;
+        bool mqtt_writable = false;
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr == nullptr)
+            {
+                mqtt_readable = (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+                mqtt_writable = (events[i].events & EPOLLOUT) != 0;
+            }
+            else
+            {
+                static_cast<EventHandler *>(events[i].data.ptr)->handle_event(events[i].events);
+            }
+        }
+        // also runs keepalives when nothing arrived
+        mqtt_handle_io(mqtt_readable, mqtt_writable);
+        mqtt_loop();
+
+        const uint32_t now = millis();
+        for (auto &bus : buses)
+        {
+            bus->framer.check_timeout(now);
+            bus->publisher_.loop();
+            bus->publisher_.metrics.set_counter(MetricsCounter::FramesLost, bus->sequence_tracker_.lost);
+            bus->publisher_.metrics.set_counter(MetricsCounter::Retransmissions, bus->sequence_tracker_.duplicates);
+            bus->publisher_.metrics.set_counter(MetricsCounter::DedupLookups, bus->frame_dedup_.lookups);
+            bus->publisher_.metrics.set_counter(MetricsCounter::DedupHits, bus->frame_dedup_.hits);
+
+            MqttMessage command;
+            while (mqtt_receive(bus->publisher_.topic_prefix + "/", command))
+            {
+                if (command.topic == bus->publisher_.topic("nasa2mqtt/filter"))
+                {
+                    ESP_LOGI(TAG, "Publish filter: %s", command.payload.c_str());
+                    bus->publisher_.filter.apply(command.payload);
+                }
+                else if (command.topic == bus->publisher_.topic("nasa2mqtt/history/get"))
+                {
+                    std::string suffix, payload;
+                    if (bus->publisher_.history.query(command.payload, now, suffix, payload))
+                        mqtt_publish(bus->publisher_.topic(suffix), payload);
+                    else
+                        ESP_LOGW(TAG, "Invalid history query '%s'", command.payload.c_str());
+                }
+            }
+        }
+
+        if (now - last_update >= update_interval)
+        {
+            last_update = now;
+            mqtt_connect(host, port, username, password);
+            footprint.sample();
+            for (auto &bus : buses)
+            {
+                log_addresses(*bus);
+                bus->publisher_.derived.save();
+                if (mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/publisher"), bus->publisher_.stats_to_json());
+                if (mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/sequence"), bus->sequence_tracker_.stats_to_json());
+                if (mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/bus"), bus->analyzer.stats_to_json(now));
+                if (mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/footprint"), footprint.stats_to_json());
+                if (mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/mqtt"), mqtt_stats_to_json());
+                if (bus->frame_dedup_.enabled() && mqtt_connected())
+                    mqtt_publish(bus->publisher_.topic("nasa2mqtt/dedup"), bus->frame_dedup_.stats_to_json());
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "Shutting down");
+    for (auto &bus : buses)
+    {
+        bus->publisher_.derived.save();
+        close(bus->fd);
+    }
+    close(epfd);
+    return 0;
+}
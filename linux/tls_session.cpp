@@ -0,0 +1,59 @@
+#include "tls_session.h"
+
+static int session_index = -1;
+
+static SSL_SESSION *kept_session(SSL_CTX *ctx)
+{
+    return (SSL_SESSION *)SSL_CTX_get_ex_data(ctx, session_index);
+}
+
+static void keep_session(SSL_CTX *ctx, SSL_SESSION *session)
+{
+    SSL_SESSION *old = kept_session(ctx);
+    if (old != nullptr)
+        SSL_SESSION_free(old);
+    SSL_CTX_set_ex_data(ctx, session_index, session);
+}
+
+// The only place a session is kept: called once the server handed out a session id or, in
+// TLS 1.3, for every ticket. Owns the reference to session when returning 1
+static int new_session(SSL *ssl, SSL_SESSION *session)
+{
+    if (!SSL_SESSION_is_resumable(session))
+        return 0;
+    keep_session(SSL_get_SSL_CTX(ssl), session);
+    return 1;
+}
+
+// An OpenSSL client only resumes the session it is given before the ClientHello goes out; the
+// library never asks for one, so it is handed over as the first handshake starts. Only offered
+// here, never taken: SSL_CB_HANDSHAKE_START also fires for renegotiation and, in TLS 1.3, for post
+// handshake messages, by then the connection has its own session.
+static void offer_session(const SSL *ssl, int where, int ret)
+{
+    if (!(where & SSL_CB_HANDSHAKE_START) || !SSL_in_before(ssl))
+        return;
+    SSL_SESSION *session = kept_session(SSL_get_SSL_CTX(ssl));
+    if (session != nullptr)
+        SSL_set_session(const_cast<SSL *>(ssl), session);
+}
+
+SSL_CTX *tls_resuming_context()
+{
+    if (session_index < 0)
+        session_index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    if (ctx == nullptr)
+        return nullptr;
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, new_session);
+    SSL_CTX_set_info_callback(ctx, offer_session);
+    return ctx;
+}
+
+void tls_forget_session(SSL_CTX *ctx)
+{
+    keep_session(ctx, nullptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <openssl/ssl.h>
+
+// Client side TLS session resumption for libraries that create a fresh SSL for every connect,
+// like libmosquitto. The context keeps the newest session the server handed out (a TLS 1.3 ticket
+// or a TLS 1.2 session id) and offers it when the next handshake starts, so a reconnect skips the
+// certificate exchange and key agreement.
+SSL_CTX *tls_resuming_context();
+// Forgets the kept session, the next handshake is a full one
+void tls_forget_session(SSL_CTX *ctx);
@@ -0,0 +1,188 @@
+// nasa2mqtt_alloc_check: fails when processing a frame allocates from the heap once warm.
+//
+// Builds against linux/alloc_hook.cpp, which counts every operator new, and replaces the MQTT client
+// with one that is always connected and accepts everything, so the whole decode and publish path
+// runs. Synthetic notifications for random catalog messages of an outdoor and an indoor unit warm
+// up every per message and per source table first; after that every frame must cost 0 allocations.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "catalog.h"
+#include "footprint.h"
+#include "mqtt.h"
+#include "nasa.h"
+#include "protocol.h"
+#include "publisher.h"
+#include "sequence.h"
+#include "dedup.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+static uint32_t mqtt_published = 0;
+
+// The MQTT client of this tool, instead of components/nasa2mqtt/mqtt.cpp
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        bool mqtt_connected()
+        {
+            return true;
+        }
+
+        void mqtt_connect(const std::string &host, const uint16_t port, const std::string &username, const std::string &password)
+        {
+        }
+
+        bool mqtt_publish(const std::string &topic, const std::string &payload, uint8_t qos, bool retain)
+        {
+            mqtt_published++;
+            return true;
+        }
+
+        const MqttOutbox &mqtt_outbox()
+        {
+            static MqttOutbox outbox;
+            return outbox;
+        }
+
+        const MqttQos1 &mqtt_qos1()
+        {
+            static MqttQos1 qos1;
+            return qos1;
+        }
+
+        bool mqtt_congested()
+        {
+            return false;
+        }
+
+        void mqtt_subscribe(const std::string &topic)
+        {
+        }
+
+        bool mqtt_receive(const std::string &prefix, MqttMessage &message)
+        {
+            return false;
+        }
+    } // namespace nasa2mqtt
+} // namespace esphome
+
+struct CheckTarget : public MessageTarget
+{
+    FrameAssembler framer;
+    Packet packet_;
+    Publisher publisher_;
+    SequenceTracker sequence_tracker_;
+    FrameDedup frame_dedup_;
+
+    void register_address(const std::string address) override {}
+    void handle_packet(Packet &packet) override {}
+
+    Publisher &publisher() override
+    {
+        return publisher_;
+    }
+
+    Packet &packet() override
+    {
+        return packet_;
+    }
+
+    SequenceTracker &sequence_tracker() override
+    {
+        return sequence_tracker_;
+    }
+
+    FrameDedup &frame_dedup() override
+    {
+        return frame_dedup_;
+    }
+};
+
+struct Source
+{
+    Address address;
+    std::vector<const MessageInfo *> messages;
+    uint8_t packet_number = 0;
+};
+
+static std::vector<uint8_t> next_frame(std::mt19937 &random, std::vector<Source> &sources)
+{
+    Source &source = sources[random() % sources.size()];
+    Packet packet;
+    packet.sa = source.address;
+    packet.da = Address::parse("B0.FF.FF");
+    packet.pcommand.packetInformation = true;
+    packet.pcommand.packetType = PacketType::Normal;
+    packet.pcommand.dataType = DataType::Notification;
+    packet.pcommand.packetNumber = source.packet_number++;
+    for (uint32_t i = 1 + random() % 10; i > 0; i--)
+    {
+        MessageSet set(source.messages[random() % source.messages.size()]->messageNumber);
+        set.value = set.type == Enum ? random() % 8 : set.type == Variable ? random() % 1000 : random() % 1000000;
+        packet.messages.push_back(set);
+    }
+    return packet.encode();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t warmup = argc > 1 ? atoi(argv[1]) : 20000;
+    uint32_t frames = argc > 2 ? atoi(argv[2]) : 100000;
+    log_level = LOG_LEVEL_ERROR;
+
+    std::vector<Source> sources(2);
+    sources[0].address = Address::parse("10.00.00");
+    sources[1].address = Address::parse("20.00.00");
+    for (size_t i = 0; i < catalog_size(); i++)
+    {
+        const MessageInfo &info = catalog_entry(i);
+        if (MessageSet(info.messageNumber).type == Structure)
+            continue;
+        if (info.group == MessageGroup::Outdoor)
+            sources[0].messages.push_back(&info);
+        else if (info.group == MessageGroup::Indoor)
+            sources[1].messages.push_back(&info);
+    }
+
+    std::mt19937 random(1);
+    CheckTarget target;
+    // short intervals, so the run sends documents and deltas
+    target.publisher_.states.setup(1000, 100);
+    target.frame_dedup_.setup(60000);
+    uint32_t allocating = 0;
+    uint32_t total = 0;
+    uint32_t most = 0;
+    for (uint32_t n = 0; n < warmup + frames; n++)
+    {
+        std::vector<uint8_t> frame = next_frame(random, sources);
+
+        const uint32_t before = heap_allocations.load();
+        for (uint8_t c : frame)
+        {
+            if (target.framer.push(c, millis()))
+                process_message(target.framer.data(), &target);
+        }
+        target.publisher_.loop();
+        const uint32_t allocations = heap_allocations.load() - before;
+
+        if (n < warmup || allocations == 0)
+            continue;
+        if (allocating++ == 0)
+            printf("first allocating frame (%u allocations): %s\n", allocations, bytes_to_hex(frame).c_str());
+        total += allocations;
+        most = std::max(most, allocations);
+    }
+
+    printf("%u frames after %u warm up frames, %u published\n", frames, warmup, mqtt_published);
+    printf("%u frames allocated, %u allocations in total, at most %u in one frame\n", allocating, total, most);
+    return allocating == 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// nasa2mqtt_fuzz_decode: checks Packet::decode against a slow reference decoder that bounds checks
+// every single read, on frames that pass size and crc but carry arbitrary message sets.
+//
+// Fuzz input is the frame between size and crc (addresses, command, capacity, message sets); the
+// harness adds start byte, size, crc and end byte so every input reaches the message set layout.
+//
+//   libFuzzer:  clang++ -DNASA2MQTT_LIBFUZZER -fsanitize=fuzzer,address,undefined ... ; ./fuzz corpus/
+//   AFL++:      afl-clang-fast++ -DNASA2MQTT_LIBFUZZER -fsanitize=fuzzer ...  (AFL++ drives libFuzzer harnesses)
+//   standalone: g++ -fsanitize=address,undefined ... ; ./fuzz [iterations] [seed], or ./fuzz - < input
+//
+// The standalone mode mutates encoded random packets (bit flips, truncation, insertion, capacity and
+// type changes) and stops at the first input the two decoders disagree on.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "esphome/core/log.h"
+#include "catalog.h"
+#include "nasa.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+struct Decoded
+{
+    uint16_t number;
+    long value;
+    std::vector<uint8_t> structure;
+};
+
+// Message sets from offset 12 (after addresses and command) up to the crc, or false when any set
+// does not fit. Written for obviousness, not speed: every byte goes through at().
+static bool reference_decode(const std::vector<uint8_t> &frame, std::vector<Decoded> &messages)
+{
+    const size_t end = frame.size() - 3;
+    size_t cursor = 12;
+    if (cursor >= end + 1)
+        return false;
+    const int capacity = frame.at(cursor++);
+    for (int i = 0; i < capacity; i++)
+    {
+        if (cursor + 2 > end)
+            return false;
+        Decoded message;
+        message.number = frame.at(cursor) << 8 | frame.at(cursor + 1);
+        message.value = 0;
+        size_t size;
+        switch ((message.number >> 9) & 3)
+        {
+        case 0:
+            size = 3;
+            break;
+        case 1:
+            size = 4;
+            break;
+        case 2:
+            size = 6;
+            break;
+        default:
+            if (capacity != 1)
+                return false;
+            size = end - cursor;
+            break;
+        }
+        if (cursor + size > end)
+            return false;
+
+        if (((message.number >> 9) & 3) == 3)
+        {
+            for (size_t j = 2; j < size; j++)
+                message.structure.push_back(frame.at(cursor + j));
+        }
+        else
+        {
+            for (size_t j = 2; j < size; j++)
+                message.value = message.value << 8 | frame.at(cursor + j);
+            if (size == 6)
+                message.value = (int32_t)message.value;
+        }
+        messages.push_back(message);
+        cursor += size;
+    }
+    return true;
+}
+
+static std::vector<uint8_t> wrap(const uint8_t *body, size_t length)
+{
+    std::vector<uint8_t> frame;
+    frame.push_back(0x32);
+    const size_t size = length + 4; // everything after the size bytes: body, crc, end byte
+    frame.push_back((uint8_t)(size >> 8));
+    frame.push_back((uint8_t)size);
+    frame.insert(frame.end(), body, body + length);
+    uint16_t crc = crc16(frame, 3, length);
+    frame.push_back((uint8_t)(crc >> 8));
+    frame.push_back((uint8_t)crc);
+    frame.push_back(0x34);
+    return frame;
+}
+
+// Aborts when the decoders disagree, so fuzzers keep the input
+static void check(const uint8_t *body, size_t length)
+{
+    std::vector<uint8_t> frame = wrap(body, length);
+
+    Packet packet;
+    const bool header = packet.decode_header(frame);
+    if (!header)
+    {
+        // only size limits fail here, the harness made size and crc right
+        if (frame.size() >= 16 && frame.size() <= 1500)
+        {
+            fprintf(stderr, "header rejected: %s\n", bytes_to_hex(frame).c_str());
+            abort();
+        }
+        return;
+    }
+
+    std::vector<Decoded> expected;
+    const bool valid = reference_decode(frame, expected);
+    const bool decoded = packet.decode_messages(frame);
+
+    bool same = valid == decoded && (!valid || expected.size() == packet.messages.size());
+    for (size_t i = 0; same && valid && i < expected.size(); i++)
+    {
+        MessageSet &message = packet.messages[i];
+        same = expected[i].number == (uint16_t)message.messageNumber;
+        if (same && message.type == Structure)
+            same = expected[i].structure == std::vector<uint8_t>(message.structure.data, message.structure.data + message.structure.size);
+        else if (same)
+            same = expected[i].value == message.value;
+    }
+    if (!same)
+    {
+        fprintf(stderr, "decoders disagree (reference %s, decoder %s): %s\n", valid ? "valid" : "invalid",
+                decoded ? "valid" : "invalid", bytes_to_hex(frame).c_str());
+        abort();
+    }
+}
+
+#ifdef NASA2MQTT_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    log_level = LOG_LEVEL_NONE;
+    check(data, size);
+    return 0;
+}
+
+#else
+
+static std::vector<uint8_t> random_body(std::mt19937 &random)
+{
+    Packet packet;
+    packet.sa = Address::parse("20.00.00");
+    packet.da = Address::parse("B0.FF.FF");
+    packet.pcommand.packetInformation = true;
+    packet.pcommand.packetType = PacketType::Normal;
+    packet.pcommand.dataType = DataType::Notification;
+    packet.pcommand.packetNumber = random();
+
+    std::vector<uint8_t> structure(random() % 40);
+    for (auto &byte : structure)
+        byte = random();
+    const uint32_t count = random() % 12;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        MessageSet set(catalog_entry(random() % catalog_size()).messageNumber);
+        if (set.type == Structure)
+        {
+            if (count > 1)
+                continue;
+            set.structure = {structure.data(), (uint16_t)structure.size()};
+        }
+        else
+            set.value = (long)(int32_t)random();
+        packet.messages.push_back(set);
+    }
+
+    std::vector<uint8_t> frame = packet.encode();
+    return std::vector<uint8_t>(frame.begin() + 3, frame.end() - 3);
+}
+
+static void mutate(std::mt19937 &random, std::vector<uint8_t> &body)
+{
+    for (uint32_t i = random() % 4; i > 0 && !body.empty(); i--)
+    {
+        size_t at = random() % body.size();
+        switch (random() % 6)
+        {
+        case 0:
+            body[at] ^= 1 << (random() % 8);
+            break;
+        case 1:
+            body.resize(at);
+            break;
+        case 2:
+            body.insert(body.begin() + at, (uint8_t)random());
+            break;
+        case 3:
+            if (body.size() > 9)
+                body[9] = random() % 16; // capacity
+            break;
+        case 4:
+            body[at] ^= 0x06; // message set type bits, when it hits a number
+            break;
+        default:
+            body.erase(body.begin() + at);
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    log_level = LOG_LEVEL_NONE;
+    if (argc > 1 && std::string(argv[1]) == "-")
+    {
+        std::vector<uint8_t> body;
+        int c;
+        while ((c = getchar()) != EOF)
+            body.push_back((uint8_t)c);
+        check(body.data(), body.size());
+        return 0;
+    }
+
+    const uint32_t iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    std::mt19937 random(argc > 2 ? atoi(argv[2]) : 1);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        std::vector<uint8_t> body = random_body(random);
+        if (i % 4 != 0)
+            mutate(random, body);
+        check(body.data(), body.size());
+    }
+    printf("%u frames, both decoders agree\n", iterations);
+    return 0;
+}
+
+#endif
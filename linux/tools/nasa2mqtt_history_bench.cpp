@@ -0,0 +1,104 @@
+// nasa2mqtt_history_bench: feeds synthetic series into the on-device history and reports what one
+// sample costs in memory and append time, and checks that a query returns exactly what was kept.
+//
+// The series mimic what the bus carries: a slowly drifting water temperature (0.1 °C steps), an
+// operation mode that rarely changes and an ever growing energy counter, all sampled about once a
+// minute with a second or two of jitter.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "esphome/core/log.h"
+#include "catalog.h"
+#include "history.h"
+#include "nasa.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+struct Workload
+{
+    const char *name;
+    MessageNumber messageNumber;
+    std::function<int32_t(std::mt19937 &, int32_t)> next;
+};
+
+static std::vector<Workload> workloads()
+{
+    return {
+        {"temperature", MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236, [](std::mt19937 &random, int32_t value)
+         { return value + (int32_t)(random() % 5) - 2; }},
+        {"mode", MessageNumber::ENUM_IN_OPERATION_MODE_4001, [](std::mt19937 &random, int32_t value)
+         { return random() % 200 == 0 ? (int32_t)(random() % 5) : value; }},
+        {"energy", MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413, [](std::mt19937 &random, int32_t value)
+         { return value + (int32_t)(random() % 40); }},
+    };
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t samples = argc > 1 ? atoi(argv[1]) : 100000;
+    const size_t bytes = argc > 2 ? atoi(argv[2]) : 4096;
+    log_level = LOG_LEVEL_ERROR;
+
+    printf("%u samples per series, %zu bytes each\n", samples, bytes);
+    printf("%-12s %10s %10s %12s %14s %8s\n", "series", "kept", "bytes", "bytes/sample", "append ns", "check");
+    int failed = 0;
+    for (auto &workload : workloads())
+    {
+        std::mt19937 random(1);
+        History history;
+        history.add_series(workload.messageNumber, bytes, 1);
+        const MessageInfo *info = find_message_info(workload.messageNumber);
+
+        // all values first, so only the append is timed
+        std::vector<uint32_t> times(samples);
+        std::vector<int32_t> values(samples);
+        uint32_t now = 1000000;
+        int32_t value = 400;
+        for (uint32_t i = 0; i < samples; i++)
+        {
+            now += 59 + random() % 3;
+            value = workload.next(random, value);
+            times[i] = now;
+            values[i] = value;
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        for (uint32_t i = 0; i < samples; i++)
+            history.add(*info, values[i], times[i] * 1000);
+        const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / samples;
+
+        // everything kept must be the tail of what went in
+        std::string suffix, payload;
+        history.query(long_to_hex((uint16_t)workload.messageNumber) + " " + std::to_string(now), now * 1000, suffix, payload);
+        std::vector<std::pair<uint32_t, int32_t>> kept;
+        const char *p = payload.c_str();
+        while ((p = strstr(p, "[")) != nullptr)
+        {
+            unsigned long age;
+            long v;
+            if (sscanf(p, "[%lu,%ld]", &age, &v) == 2)
+                kept.emplace_back(now - age, v);
+            p++;
+        }
+        bool ok = !kept.empty() && kept.size() <= samples;
+        for (size_t i = 0; ok && i < kept.size(); i++)
+        {
+            size_t source = samples - kept.size() + i;
+            ok = kept[i].first == times[source] && kept[i].second == values[source];
+        }
+        failed += ok ? 0 : 1;
+
+        printf("%-12s %10zu %10zu %12.2f %14.1f %8s\n", workload.name, kept.size(), bytes,
+               kept.empty() ? 0.0 : (double)bytes / kept.size(), ns, ok ? "ok" : "FAILED");
+    }
+    return failed == 0 ? 0 : 1;
+}
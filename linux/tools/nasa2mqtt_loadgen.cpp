@@ -0,0 +1,301 @@
+// nasa2mqtt_loadgen: pushes synthetic NASA traffic through the real frame assembler, decoder and
+// publisher and reports throughput, per frame processing latency and loss.
+//
+// Emulates one outdoor unit and N indoor units, each with its own packet counter, sending
+// notifications with random values for random catalog messages of their group. Frames can be
+// corrupted, dropped or repeated on purpose to check that the sequence tracker sees exactly that.
+// Devices can also send their previous notification again with a new packet number, as real units
+// do most of the time, to measure what the frame dedup saves.
+// MQTT is not connected, so publishing ends in the publisher's dropped counter.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "catalog.h"
+#include "nasa.h"
+#include "protocol.h"
+#include "publisher.h"
+#include "sequence.h"
+#include "dedup.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+// 9600 baud 8E1
+static const double LINE_BYTES_PER_SECOND = 9600.0 / 11;
+
+struct LoadTarget : public MessageTarget
+{
+    FrameAssembler framer;
+    Packet packet_;
+    Publisher publisher_;
+    SequenceTracker sequence_tracker_;
+    FrameDedup frame_dedup_;
+    uint32_t decoded = 0;
+
+    void register_address(const std::string address) override {}
+
+    void handle_packet(Packet &packet) override
+    {
+        decoded++;
+    }
+
+    Publisher &publisher() override
+    {
+        return publisher_;
+    }
+
+    Packet &packet() override
+    {
+        return packet_;
+    }
+
+    SequenceTracker &sequence_tracker() override
+    {
+        return sequence_tracker_;
+    }
+
+    FrameDedup &frame_dedup() override
+    {
+        return frame_dedup_;
+    }
+};
+
+struct Device
+{
+    Address address;
+    MessageGroup group;
+    uint8_t packet_number = 0;
+    std::vector<MessageSet> previous;
+};
+
+struct Options
+{
+    uint32_t frames = 100000;
+    uint32_t indoor = 1;
+    double rate = 0;
+    double corrupt = 0;
+    double drop = 0;
+    double repeat = 0;
+    double same = 0;
+    uint32_t dedup = 0; // max age in s, 0 without dedup
+    uint32_t max_messages = 10;
+    uint32_t seed = 1;
+};
+
+struct Injected
+{
+    uint32_t corrupted = 0;
+    uint32_t dropped = 0;
+    uint32_t repeated = 0;
+};
+
+static long random_value(std::mt19937 &random, MessageSetType type)
+{
+    switch (type)
+    {
+    case Enum:
+        return random() & 0xFF;
+    case Variable:
+        return random() & 0xFFFF;
+    default:
+        return (long)(int32_t)random();
+    }
+}
+
+// One byte stream with all frames in bus order, built before the clock starts
+static std::vector<uint8_t> generate(const Options &options, std::mt19937 &random, Injected &injected, uint32_t &frames)
+{
+    std::vector<Device> devices;
+    devices.push_back({Address::parse("10.00.00"), MessageGroup::Outdoor});
+    for (uint32_t i = 0; i < options.indoor; i++)
+        devices.push_back({Address::parse("20.00.00"), MessageGroup::Indoor});
+    for (uint32_t i = 0; i < options.indoor; i++)
+        devices[i + 1].address.address = i;
+
+    // candidate messages per group, structures excluded since they travel alone
+    std::vector<const MessageInfo *> outdoor, indoor;
+    for (size_t i = 0; i < catalog_size(); i++)
+    {
+        const MessageInfo &info = catalog_entry(i);
+        if (MessageSet(info.messageNumber).type == Structure)
+            continue;
+        if (info.group == MessageGroup::Outdoor)
+            outdoor.push_back(&info);
+        else if (info.group == MessageGroup::Indoor)
+            indoor.push_back(&info);
+    }
+
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::vector<uint8_t> stream;
+    frames = 0;
+    for (uint32_t n = 0; n < options.frames; n++)
+    {
+        Device &device = devices[random() % devices.size()];
+        auto &candidates = device.group == MessageGroup::Outdoor ? outdoor : indoor;
+
+        Packet packet;
+        packet.sa = device.address;
+        packet.da = Address::parse("B0.FF.FF");
+        packet.pcommand.packetInformation = true;
+        packet.pcommand.packetType = PacketType::Normal;
+        packet.pcommand.dataType = DataType::Notification;
+        packet.pcommand.packetNumber = device.packet_number++;
+
+        if (!device.previous.empty() && chance(random) < options.same)
+            packet.messages = device.previous;
+        else
+        {
+            uint32_t count = 1 + random() % std::min<size_t>(options.max_messages, candidates.size());
+            for (uint32_t i = 0; i < count; i++)
+            {
+                MessageSet set(candidates[random() % candidates.size()]->messageNumber);
+                set.value = random_value(random, set.type);
+                packet.messages.push_back(set);
+            }
+            device.previous = packet.messages;
+        }
+        std::vector<uint8_t> frame = packet.encode();
+
+        if (chance(random) < options.drop)
+        {
+            injected.dropped++;
+            continue;
+        }
+        if (chance(random) < options.corrupt)
+        {
+            frame[random() % frame.size()] ^= 1 << (random() % 8);
+            injected.corrupted++;
+        }
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        frames++;
+        if (chance(random) < options.repeat)
+        {
+            stream.insert(stream.end(), frame.begin(), frame.end());
+            injected.repeated++;
+            frames++;
+        }
+    }
+    return stream;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --frames <n>        frames to generate (default 100000)\n"
+            "  --indoor <n>        indoor units next to the outdoor unit (default 1)\n"
+            "  --rate <factor>     pace the stream at factor times 9600 baud, 0 = as fast as possible (default)\n"
+            "  --messages <n>      at most n messages per frame (default 10)\n"
+            "  --corrupt <p>       probability of one flipped bit per frame\n"
+            "  --drop <p>          probability a frame never makes it onto the bus\n"
+            "  --repeat <p>        probability a frame is sent twice\n"
+            "  --same <p>          probability a device sends its previous messages and values again\n"
+            "  --dedup <s>         skip notifications identical to the last of their kind (max age s)\n"
+            "  --seed <n>\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 == argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *value = argv[++i];
+        if (arg == "--frames")
+            options.frames = atoi(value);
+        else if (arg == "--indoor")
+            options.indoor = atoi(value);
+        else if (arg == "--rate")
+            options.rate = atof(value);
+        else if (arg == "--messages")
+            options.max_messages = std::max(1, atoi(value));
+        else if (arg == "--corrupt")
+            options.corrupt = atof(value);
+        else if (arg == "--drop")
+            options.drop = atof(value);
+        else if (arg == "--repeat")
+            options.repeat = atof(value);
+        else if (arg == "--same")
+            options.same = atof(value);
+        else if (arg == "--dedup")
+            options.dedup = atoi(value);
+        else if (arg == "--seed")
+            options.seed = atoi(value);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    log_level = LOG_LEVEL_ERROR;
+
+    std::mt19937 random(options.seed);
+    Injected injected;
+    uint32_t frames;
+    std::vector<uint8_t> stream = generate(options, random, injected, frames);
+
+    LoadTarget target;
+    target.frame_dedup_.setup(options.dedup * 1000);
+    std::vector<uint32_t> latencies;
+    latencies.reserve(frames);
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const double bytes_per_second = options.rate * LINE_BYTES_PER_SECOND;
+    uint32_t late = 0;
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+        if (bytes_per_second > 0 && stream[i] == 0x32 && !target.framer.receiving())
+        {
+            auto due = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(i / bytes_per_second));
+            if (clock::now() > due + std::chrono::milliseconds(10))
+                late++;
+            std::this_thread::sleep_until(due);
+        }
+
+        if (!target.framer.push(stream[i], millis()))
+            continue;
+
+        const uint32_t begin = micros();
+        process_message(target.framer.data(), &target);
+        latencies.push_back(micros() - begin);
+        target.publisher_.loop();
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    {
+        return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+    };
+
+    printf("devices:     1 outdoor, %u indoor\n", options.indoor);
+    printf("sent:        %u frames, %zu bytes (%u corrupted, %u repeated; %u dropped before the bus)\n",
+           frames, stream.size(), injected.corrupted, injected.repeated, injected.dropped);
+    printf("time:        %.3f s, %.0f frames/s, %.0f bytes/s = %.1f x line rate%s\n",
+           seconds, frames / seconds, stream.size() / seconds, stream.size() / seconds / LINE_BYTES_PER_SECOND,
+           late > 0 ? " (fell behind the pace)" : "");
+    printf("decoded:     %u frames, %zu cut by the assembler, %u retransmissions dropped\n",
+           target.decoded, latencies.size(), target.sequence_tracker_.duplicates);
+    printf("loss:        %u frames seen as lost by the sequence tracker\n", target.sequence_tracker_.lost);
+    printf("latency us:  min %u, p50 %u, p99 %u, max %u\n",
+           percentile(0), percentile(0.5), percentile(0.99), latencies.empty() ? 0 : latencies.back());
+    if (target.frame_dedup_.enabled())
+        printf("dedup:       %s\n", target.frame_dedup_.stats_to_json().c_str());
+    printf("publisher:   %s\n", target.publisher_.stats_to_json().c_str());
+    return 0;
+}
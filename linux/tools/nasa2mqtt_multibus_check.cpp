@@ -0,0 +1,311 @@
+// nasa2mqtt_multibus_check: runs three buses side by side, the way one gateway serves several NASA
+// buses, and fails when anything of one bus shows up on another.
+//
+// Every bus has an outdoor and an indoor unit with the same addresses as on the other buses, its own
+// topic prefix, frame assembler, publisher and sequence tracker. The bytes of the buses are fed
+// interleaved, one byte per bus in turn. Values tell the bus they came from (value % 3 == bus), bus 0
+// loses frames, bus 1 repeats frames, bus 1 switches the outdoor group off in its runtime filter and
+// only bus 0 carries the electrical power that derived energy is integrated from.
+//
+// Builds like the allocation check without alloc_hook.cpp: the MQTT client below records what is
+// published instead of components/nasa2mqtt/mqtt.cpp.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "catalog.h"
+#include "mqtt.h"
+#include "nasa.h"
+#include "protocol.h"
+#include "publisher.h"
+#include "sequence.h"
+#include "dedup.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+// topic -> last payload, over all buses
+static std::map<std::string, std::string> published;
+
+// The MQTT client of this tool, instead of components/nasa2mqtt/mqtt.cpp
+namespace esphome
+{
+    namespace nasa2mqtt
+    {
+        bool mqtt_connected()
+        {
+            return true;
+        }
+
+        void mqtt_connect(const std::string &host, const uint16_t port, const std::string &username, const std::string &password)
+        {
+        }
+
+        bool mqtt_publish(const std::string &topic, const std::string &payload, uint8_t qos, bool retain)
+        {
+            published[topic] = payload;
+            return true;
+        }
+
+        const MqttOutbox &mqtt_outbox()
+        {
+            static MqttOutbox outbox;
+            return outbox;
+        }
+
+        const MqttQos1 &mqtt_qos1()
+        {
+            static MqttQos1 qos1;
+            return qos1;
+        }
+
+        bool mqtt_congested()
+        {
+            return false;
+        }
+
+        void mqtt_subscribe(const std::string &topic)
+        {
+        }
+
+        bool mqtt_receive(const std::string &prefix, MqttMessage &message)
+        {
+            return false;
+        }
+    } // namespace nasa2mqtt
+} // namespace esphome
+
+struct CheckBus : public MessageTarget
+{
+    FrameAssembler framer;
+    Packet packet_;
+    Publisher publisher_;
+    SequenceTracker sequence_tracker_;
+    FrameDedup frame_dedup_;
+
+    void register_address(const std::string address) override {}
+    void handle_packet(Packet &packet) override {}
+
+    Publisher &publisher() override
+    {
+        return publisher_;
+    }
+
+    Packet &packet() override
+    {
+        return packet_;
+    }
+
+    SequenceTracker &sequence_tracker() override
+    {
+        return sequence_tracker_;
+    }
+
+    FrameDedup &frame_dedup() override
+    {
+        return frame_dedup_;
+    }
+};
+
+static const size_t BUSES = 3;
+
+struct Unit
+{
+    Address address;
+    std::vector<MessageNumber> messages;
+    uint8_t packet_number = 0;
+};
+
+struct Traffic
+{
+    std::vector<uint8_t> bytes;
+    uint32_t dropped = 0;
+    uint32_t repeated = 0;
+    // last value sent per message, by state topic
+    std::map<std::string, long> last;
+};
+
+static int failures = 0;
+
+static void expect(bool condition, const std::string &what)
+{
+    if (condition)
+        return;
+    printf("  %s\n", what.c_str());
+    failures++;
+}
+
+static std::string state_topic(const std::string &prefix, MessageNumber messageNumber)
+{
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%02x/state", prefix.c_str(), (uint16_t)messageNumber);
+    return topic;
+}
+
+static Traffic generate(size_t bus, const std::string &prefix, uint32_t frames, std::mt19937 &random)
+{
+    std::vector<Unit> units(2);
+    units[0].address = Address::parse("10.00.00");
+    units[1].address = Address::parse("20.00.00");
+    for (size_t i = 0; i < catalog_size(); i++)
+    {
+        const MessageInfo &info = catalog_entry(i);
+        if (MessageSet(info.messageNumber).type == Structure)
+            continue;
+        // only bus 0 has a power meter
+        if (info.messageNumber == MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413 && bus != 0)
+            continue;
+        if (info.group == MessageGroup::Outdoor)
+            units[0].messages.push_back(info.messageNumber);
+        else if (info.group == MessageGroup::Indoor)
+            units[1].messages.push_back(info.messageNumber);
+    }
+    // the inputs of heat output in every frame of the indoor unit, so derived metrics get going
+    const MessageNumber water[] = {MessageNumber::VAR_IN_FLOW_SENSOR_CALC_42E9, MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236,
+                                   MessageNumber::VAR_IN_TEMP_WATER_OUT_F_4238};
+
+    Traffic traffic;
+    std::uniform_real_distribution<double> chance(0, 1);
+    for (uint32_t n = 0; n < frames; n++)
+    {
+        Unit &unit = units[random() % units.size()];
+        Packet packet;
+        packet.sa = unit.address;
+        packet.da = Address::parse("B0.FF.FF");
+        packet.pcommand.packetInformation = true;
+        packet.pcommand.packetType = PacketType::Normal;
+        packet.pcommand.dataType = DataType::Notification;
+        packet.pcommand.packetNumber = unit.packet_number++;
+
+        std::vector<MessageNumber> numbers;
+        for (uint32_t i = 1 + random() % 8; i > 0; i--)
+            numbers.push_back(unit.messages[random() % unit.messages.size()]);
+        if (&unit == &units[1])
+            numbers.insert(numbers.end(), water, water + 3);
+        else if (bus == 0)
+            numbers.push_back(MessageNumber::LVAR_OUT_CONTROL_WATTMETER_1W_1MIN_SUM_8413);
+
+        for (MessageNumber number : numbers)
+        {
+            MessageSet set(number);
+            set.value = (long)(random() % (set.type == Enum ? 80 : 10000)) * BUSES + bus;
+            packet.messages.push_back(set);
+        }
+
+        // a frame lost at the very end would never be noticed
+        if (bus == 0 && n + 100 < frames && chance(random) < 0.02)
+        {
+            traffic.dropped++;
+            continue;
+        }
+        for (auto &set : packet.messages)
+            traffic.last[state_topic(prefix, set.messageNumber)] = set.value;
+        std::vector<uint8_t> frame = packet.encode();
+        traffic.bytes.insert(traffic.bytes.end(), frame.begin(), frame.end());
+        if (bus == 1 && chance(random) < 0.02)
+        {
+            traffic.bytes.insert(traffic.bytes.end(), frame.begin(), frame.end());
+            traffic.repeated++;
+        }
+    }
+    return traffic;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t frames = argc > 1 ? atoi(argv[1]) : 20000;
+    log_level = LOG_LEVEL_ERROR;
+
+    std::mt19937 random(1);
+    CheckBus buses[BUSES];
+    Traffic traffic[BUSES];
+    for (size_t bus = 0; bus < BUSES; bus++)
+    {
+        Publisher &publisher = buses[bus].publisher_;
+        publisher.topic_prefix = "samsung_ehs_" + std::to_string(bus);
+        publisher.derived.set_enabled(true);
+        publisher.derived.setup(publisher.topic_prefix);
+        publisher.filter.setup(publisher.topic_prefix);
+        traffic[bus] = generate(bus, publisher.topic_prefix, frames, random);
+    }
+    buses[1].publisher_.filter.apply("-outdoor");
+
+    // one byte of every bus in turn, as the loop drains the UARTs
+    for (size_t i = 0;; i++)
+    {
+        bool more = false;
+        for (size_t bus = 0; bus < BUSES; bus++)
+        {
+            if (i >= traffic[bus].bytes.size())
+                continue;
+            more = true;
+            if (buses[bus].framer.push(traffic[bus].bytes[i], millis()))
+                process_message(buses[bus].framer.data(), &buses[bus]);
+        }
+        if (!more)
+            break;
+        // time for the energy integrals
+        if (i % 20000 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (auto &bus : buses)
+        bus.publisher_.loop();
+
+    printf("%u frames per bus, %zu topics published\n", frames, published.size());
+    printf("%-14s %8s %8s %8s %8s %10s %10s\n", "bus", "topics", "dropped", "lost", "repeated", "duplicates", "energy kWh");
+
+    for (size_t bus = 0; bus < BUSES; bus++)
+    {
+        const std::string prefix = buses[bus].publisher_.topic_prefix + "/";
+        const SequenceTracker &tracker = buses[bus].sequence_tracker_;
+        size_t topics = 0;
+        for (auto &entry : published)
+        {
+            // samsung_ehs_1/ is not a prefix of samsung_ehs_10/, all buses here have one digit
+            if (entry.first.compare(0, prefix.length(), prefix) != 0)
+                continue;
+            topics++;
+            const std::string &topic = entry.first;
+            if (topic.find("/state") != topic.length() - 6 || topic.find('/', prefix.length()) != topic.length() - 6)
+                continue;
+            const long value = atol(entry.second.c_str());
+            expect(value % (long)BUSES == (long)bus, topic + " carries " + entry.second + ", a value of another bus");
+            auto sent = traffic[bus].last.find(topic);
+            expect(sent != traffic[bus].last.end(), topic + " published but never sent on this bus");
+            if (sent != traffic[bus].last.end())
+                expect(sent->second == value, topic + " is " + entry.second + ", last sent " + std::to_string(sent->second));
+            const MessageInfo *info = find_message_info((MessageNumber)hex_to_int(topic.substr(prefix.length(), topic.length() - prefix.length() - 6)));
+            expect(bus != 1 || info == nullptr || info->group != MessageGroup::Outdoor, topic + " published although bus 1 filters outdoor");
+        }
+
+        // the filter of bus 1 must not have switched outdoor off elsewhere
+        if (bus != 1)
+            expect(published.count(state_topic(buses[bus].publisher_.topic_prefix, MessageNumber::VAR_OUT_SENSOR_AIROUT_8204)) == 1,
+                   prefix + " lacks the outdoor temperature");
+
+        expect(tracker.lost == traffic[bus].dropped, prefix + " lost " + std::to_string(tracker.lost) + " frames, " +
+                                                        std::to_string(traffic[bus].dropped) + " dropped");
+        expect(tracker.duplicates == traffic[bus].repeated, prefix + " saw " + std::to_string(tracker.duplicates) +
+                                                                " duplicates, " + std::to_string(traffic[bus].repeated) + " repeated");
+
+        // energy consumed comes from the power meter, which only bus 0 has; heat output from every bus
+        auto energy = published.find(prefix + "derived/energy_consumed");
+        expect((energy != published.end()) == (bus == 0), prefix + (bus == 0 ? " lacks" : " has") + " energy consumed");
+        expect(published.count(prefix + "derived/heat_output") == 1, prefix + " lacks heat output");
+        expect(published.count(prefix + "derived/cop") == (bus == 0 ? 1u : 0u), prefix + " COP without its inputs");
+
+        printf("%-14s %8zu %8u %8u %8u %10u %10s\n", buses[bus].publisher_.topic_prefix.c_str(), topics, traffic[bus].dropped,
+               tracker.lost, traffic[bus].repeated, tracker.duplicates, energy != published.end() ? energy->second.c_str() : "-");
+    }
+
+    printf("%s\n", failures == 0 ? "buses kept apart" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
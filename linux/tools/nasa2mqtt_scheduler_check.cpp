@@ -0,0 +1,239 @@
+// nasa2mqtt_scheduler_check: runs the RequestScheduler against a simulated bus in simulated time and
+// checks what it promises: requests at least REQUEST_SPACING_MS apart, never more than
+// MAX_PENDING_REQUESTS unanswered, each configured message once per interval in batches for one
+// unit, and a timeout for exactly the requests without a response within REQUEST_TIMEOUT_MS.
+//
+// The units send notifications of their own, answer read requests after a fixed latency and can
+// lose requests; the gateway side polls with the same idle gating as NASA2MQTT::loop. Every frame
+// goes through Packet::encode and Packet::decode like on the bus. With the current constants the
+// spacing alone keeps a silent unit at MAX_PENDING_REQUESTS; "slow" and "silent" reach it, the check
+// is that nothing goes over.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "esphome/core/log.h"
+#include "nasa.h"
+#include "scheduler.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+// 9600 baud 8E1
+static const double MS_PER_BYTE = 11 * 1000.0 / 9600;
+
+struct Scenario
+{
+    const char *name;
+    uint32_t latency; // ms from request to response
+    double loss;      // probability a request is never answered
+};
+
+struct Request
+{
+    Address unit;
+    uint32_t sent;
+    uint8_t packetNumber;
+    bool answered = false; // the scheduler took the response
+    uint32_t answer_due = 0;
+    bool lost = false;
+};
+
+static const uint16_t MESSAGES[] = {0x4236, 0x4238, 0x4247, 0x4248, 0x4203, 0x061F, 0x8204, 0x8206, 0x8217, 0x82E3};
+static const uint32_t INTERVAL_MS = 20000;
+static const uint8_t BATCH_SIZE = 3;
+static const uint32_t DURATION_MS = 10 * 60 * 1000;
+
+static int failures = 0;
+
+static void expect(bool condition, const char *scenario, const std::string &what)
+{
+    if (condition)
+        return;
+    printf("  %s: %s\n", scenario, what.c_str());
+    failures++;
+}
+
+static bool run(const Scenario &scenario)
+{
+    const int failures_before = failures;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> chance(0, 1);
+
+    RequestScheduler scheduler;
+    for (uint16_t number : MESSAGES)
+        scheduler.add_message(number);
+    scheduler.set_interval(INTERVAL_MS);
+    scheduler.set_batch_size(BATCH_SIZE);
+
+    std::vector<Request> requests;
+    std::vector<uint32_t> requested(sizeof(MESSAGES) / sizeof(MESSAGES[0]), 0);
+    std::vector<uint32_t> cycle_starts;
+    uint32_t busy_until = 0; // end of the frame on the bus
+    uint32_t next_notification = 100;
+    uint32_t last_tx = 0;
+    uint8_t packet_number = 0;
+    uint32_t min_spacing = UINT32_MAX;
+    size_t max_pending = 0;
+    uint32_t late_responses = 0;
+    uint32_t timeouts_seen = 0;
+
+    for (uint32_t now = 1; now < DURATION_MS; now++)
+    {
+        // units talk on their own every few hundred ms
+        if (now >= next_notification && now >= busy_until)
+        {
+            busy_until = now + (uint32_t)(30 * MS_PER_BYTE);
+            next_notification = now + 200 + random() % 400;
+        }
+
+        // responses that are due
+        for (auto &request : requests)
+        {
+            if (request.lost || request.answer_due != now)
+                continue;
+            Packet response;
+            response.sa = request.unit;
+            response.da = Address::get_my_address();
+            response.pcommand.packetInformation = true;
+            response.pcommand.packetType = PacketType::Normal;
+            response.pcommand.dataType = DataType::Response;
+            response.pcommand.packetNumber = request.packetNumber;
+            MessageSet set(MessageNumber::VAR_IN_TEMP_WATER_IN_F_4236);
+            set.value = 250;
+            response.messages.push_back(set);
+            std::vector<uint8_t> frame = response.encode();
+            busy_until = std::max(busy_until, now) + (uint32_t)(frame.size() * MS_PER_BYTE);
+
+            Packet packet;
+            expect(packet.decode(frame), scenario.name, "response does not decode");
+            const bool in_time = now - request.sent < REQUEST_TIMEOUT_MS;
+            const bool taken = scheduler.handle_response(packet, now);
+            expect(taken == in_time, scenario.name,
+                   "response " + std::to_string(now - request.sent) + " ms after the request " + (taken ? "taken" : "ignored"));
+            request.answered = taken;
+            late_responses += in_time ? 0 : 1;
+        }
+
+        // the idle gating of NASA2MQTT::loop
+        if (now < busy_until + BUS_IDLE_GAP_MS || now - last_tx < BUS_IDLE_GAP_MS)
+            continue;
+
+        std::vector<uint8_t> frame;
+        const bool sent = scheduler.poll(now, packet_number, frame);
+
+        // a timeout may only be counted for a request that is really overdue
+        uint32_t overdue = 0;
+        for (auto &request : requests)
+            overdue += !request.answered && now - request.sent >= REQUEST_TIMEOUT_MS ? 1 : 0;
+        expect(scheduler.timeouts <= overdue, scenario.name,
+               std::to_string(scheduler.timeouts) + " timeouts but only " + std::to_string(overdue) + " requests overdue");
+        timeouts_seen = scheduler.timeouts;
+
+        if (!sent)
+            continue;
+
+        size_t pending = 0;
+        for (auto &request : requests)
+            pending += !request.answered && now - request.sent < REQUEST_TIMEOUT_MS ? 1 : 0;
+        max_pending = std::max(max_pending, pending + 1);
+        expect(pending < MAX_PENDING_REQUESTS, scenario.name,
+               "request sent with " + std::to_string(pending) + " requests pending");
+        if (!requests.empty())
+        {
+            min_spacing = std::min(min_spacing, now - requests.back().sent);
+            expect(now - requests.back().sent >= REQUEST_SPACING_MS, scenario.name,
+                   "requests " + std::to_string(now - requests.back().sent) + " ms apart");
+        }
+
+        Packet packet;
+        expect(packet.decode(frame), scenario.name, "request does not decode");
+        expect(packet.pcommand.dataType == DataType::Read, scenario.name, "request is not a read");
+        expect(!packet.messages.empty() && packet.messages.size() <= BATCH_SIZE, scenario.name,
+               std::to_string(packet.messages.size()) + " messages in one request");
+        for (auto &message : packet.messages)
+        {
+            const uint16_t number = (uint16_t)message.messageNumber;
+            const bool outdoor = (number & 0x8000) != 0;
+            expect(packet.da.aclass == (outdoor ? AddressClass::Outdoor : AddressClass::Indoor), scenario.name,
+                   long_to_hex(number) + " requested from " + packet.da.to_string());
+            expect(message.type != Structure || packet.messages.size() == 1, scenario.name,
+                   "structure " + long_to_hex(number) + " batched with other messages");
+            for (size_t i = 0; i < requested.size(); i++)
+            {
+                if (MESSAGES[i] == number)
+                    requested[i]++;
+            }
+            if (number == MESSAGES[0])
+                cycle_starts.push_back(now);
+        }
+
+        Request request;
+        request.unit = packet.da;
+        request.sent = now;
+        request.packetNumber = packet.pcommand.packetNumber;
+        request.lost = chance(random) < scenario.loss;
+        request.answer_due = now + scenario.latency;
+        requests.push_back(request);
+
+        busy_until = now + (uint32_t)(frame.size() * MS_PER_BYTE);
+        last_tx = now;
+    }
+
+    // every request overdue by the end got its timeout, none other did
+    uint32_t unanswered = 0, overdue = 0;
+    for (auto &request : requests)
+    {
+        if (request.answered)
+            continue;
+        unanswered++;
+        overdue += DURATION_MS - request.sent > REQUEST_TIMEOUT_MS + REQUEST_SPACING_MS ? 1 : 0;
+    }
+    expect(scheduler.timeouts >= overdue && scheduler.timeouts <= unanswered, scenario.name,
+           std::to_string(scheduler.timeouts) + " timeouts for " + std::to_string(overdue) + " overdue requests");
+    uint32_t answered = 0;
+    for (auto &request : requests)
+        answered += request.answered ? 1 : 0;
+    expect(scheduler.responses == answered, scenario.name,
+           std::to_string(scheduler.responses) + " responses counted, " + std::to_string(answered) + " taken");
+    expect(scheduler.requests_sent == requests.size(), scenario.name, "requests_sent does not match the bus");
+
+    // once per interval, unless timeouts slow the cycle down
+    for (size_t i = 1; i < cycle_starts.size(); i++)
+        expect(cycle_starts[i] - cycle_starts[i - 1] >= INTERVAL_MS, scenario.name,
+               "cycle after " + std::to_string(cycle_starts[i] - cycle_starts[i - 1]) + " ms");
+    auto fewest = std::min_element(requested.begin(), requested.end());
+    auto most = std::max_element(requested.begin(), requested.end());
+    expect(*fewest > 0 && *most - *fewest <= 1, scenario.name,
+           "messages requested between " + std::to_string(*fewest) + " and " + std::to_string(*most) + " times");
+
+    printf("%-10s %8zu %8u %8u %8u %8zu %8u %8s\n", scenario.name, requests.size(), scheduler.responses, timeouts_seen,
+           late_responses, max_pending, min_spacing == UINT32_MAX ? 0 : min_spacing, failures == failures_before ? "ok" : "FAILED");
+    return failures == failures_before;
+}
+
+int main(int argc, char **argv)
+{
+    log_level = LOG_LEVEL_ERROR;
+
+    const Scenario scenarios[] = {
+        {"answered", 120, 0},
+        {"lossy", 300, 0.3},
+        // responses close to the timeout keep MAX_PENDING_REQUESTS in flight
+        {"slow", REQUEST_TIMEOUT_MS - 100, 0},
+        {"late", REQUEST_TIMEOUT_MS + 500, 0},
+        {"silent", 0, 1},
+    };
+
+    printf("%zu messages, interval %u ms, batches of %u, %u s simulated\n", sizeof(MESSAGES) / sizeof(MESSAGES[0]),
+           INTERVAL_MS, BATCH_SIZE, DURATION_MS / 1000);
+    printf("%-10s %8s %8s %8s %8s %8s %8s %8s\n", "scenario", "sent", "answers", "timeouts", "late", "pending", "spacing", "check");
+    bool ok = true;
+    for (auto &scenario : scenarios)
+        ok = run(scenario) && ok;
+    return ok ? 0 : 1;
+}
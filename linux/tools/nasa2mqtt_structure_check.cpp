@@ -0,0 +1,78 @@
+// nasa2mqtt_structure_check: decodes structure frames in the layout the units send them and checks
+// what gets published, and that frames whose structure does not fit are dropped whole.
+//
+// Model name (0x61F) and serial number (0x607) come as NUL padded ASCII, alone in their frame. The
+// broken ones: a model name frame cut off on the wire, one whose message set ends inside the message
+// number and one that has a structure next to another message set.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "esphome/core/log.h"
+#include "nasa.h"
+#include "structure.h"
+#include "util.h"
+
+using namespace esphome;
+using namespace esphome::nasa2mqtt;
+
+struct Case
+{
+    const char *name;
+    const char *frame; // hex, start byte to end byte
+    bool header;       // size and crc check out
+    bool messages;     // the message set layout checks out
+    uint16_t number;   // of the one structure, when it decodes
+    const char *payload;
+};
+
+static const Case CASES[] = {
+    {"model name", "320024200000b0ffffc0145a01061f41453136305258594447472f4555000000000000143034",
+     true, true, 0x61F, "AE160RXYDGG/EU"},
+    {"serial number", "320024200000b0ffffc0145b01060730544b345041464e353030313233580000000000168734",
+     true, true, 0x607, "0TK4PAFN500123X"},
+    {"cut on the wire", "320024200000b0ffffc0145a01061f41453136305258594447472f4555",
+     false, false, 0, nullptr},
+    {"ends in the number", "32000f200000b0ffffc0145c01067a5f34",
+     true, false, 0, nullptr},
+    {"structure and enum", "320022200000b0ffffc0145d02061f41453136305258594447472f455500400001258734",
+     true, false, 0, nullptr},
+};
+
+int main(int argc, char **argv)
+{
+    log_level = LOG_LEVEL_NONE;
+
+    int failed = 0;
+    for (auto &test : CASES)
+    {
+        std::vector<uint8_t> frame = hex_to_bytes(test.frame);
+        Packet packet;
+        const bool header = packet.decode_header(frame);
+        const bool messages = header && packet.decode_messages(frame);
+
+        std::string payload;
+        bool ok = header == test.header && messages == test.messages;
+        if (ok && messages)
+        {
+            MessageSet &set = packet.messages[0];
+            ok = packet.messages.size() == 1 && set.type == Structure && (uint16_t)set.messageNumber == test.number &&
+                 set.structure.data >= frame.data() && set.structure.data + set.structure.size <= frame.data() + frame.size() - 3;
+            if (ok)
+            {
+                payload = structure_to_payload(set.messageNumber, set.structure);
+                ok = payload == test.payload;
+            }
+        }
+        else if (ok)
+        {
+            // a rejected layout leaves nothing half decoded behind
+            ok = packet.messages.empty();
+        }
+        failed += ok ? 0 : 1;
+
+        printf("%-20s %-8s %-9s %-20s %s\n", test.name, header ? "header" : "-", messages ? "messages" : "-",
+               messages ? ("\"" + payload + "\"").c_str() : "-", ok ? "ok" : "FAILED");
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// nasa2mqtt_tls_reconnect: measures how long an MQTT over TLS (re)connect takes, with a full handshake
+// every time and with the session kept by linux/tls_session.cpp, the way the daemon reconnects.
+//
+// Each connect is TCP connect, TLS handshake, MQTT CONNECT and the broker's CONNACK, then DISCONNECT.
+// Reports wall time and the CPU time this process spent, which is what a handshake costs a small chip:
+//
+//   ./nasa2mqtt_tls_reconnect --host localhost --port 8883 --ca ca.crt --count 50
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/err.h>
+#include "tls_session.h"
+
+struct Sample
+{
+    double wall_ms;
+    double cpu_ms;
+    bool resumed;
+};
+
+static double now_ms(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int tcp_connect(const std::string &host, const std::string &port)
+{
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0)
+        return -1;
+    int fd = -1;
+    for (addrinfo *ai = result; ai != nullptr && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    // the handshake is a few small writes in a row, Nagle would add a delayed ACK to each round trip
+    int on = 1;
+    if (fd >= 0)
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+// MQTT 3.1.1 CONNECT with clean session and a 60 s keep alive
+static std::vector<uint8_t> connect_packet(const std::string &client_id)
+{
+    std::vector<uint8_t> packet = {0x10, 0, 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 60,
+                                   (uint8_t)(client_id.size() >> 8), (uint8_t)client_id.size()};
+    packet.insert(packet.end(), client_id.begin(), client_id.end());
+    packet[1] = (uint8_t)(packet.size() - 2);
+    return packet;
+}
+
+static bool mqtt_connect_once(SSL_CTX *ctx, const std::string &host, const std::string &port, Sample &sample)
+{
+    const double wall = now_ms(CLOCK_MONOTONIC);
+    const double cpu = now_ms(CLOCK_PROCESS_CPUTIME_ID);
+
+    int fd = tcp_connect(host, port);
+    if (fd < 0)
+    {
+        fprintf(stderr, "connect to %s:%s failed\n", host.c_str(), port.c_str());
+        return false;
+    }
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, host.c_str());
+    SSL_set1_host(ssl, host.c_str());
+
+    bool ok = SSL_connect(ssl) == 1;
+    if (ok)
+    {
+        std::vector<uint8_t> connect = connect_packet("nasa2mqtt_tls_reconnect");
+        uint8_t connack[4];
+        ok = SSL_write(ssl, connect.data(), connect.size()) == (int)connect.size() &&
+             SSL_read(ssl, connack, sizeof(connack)) == sizeof(connack) && connack[0] == 0x20 && connack[3] == 0;
+        if (!ok)
+            fprintf(stderr, "no CONNACK, or the broker refused the connection\n");
+    }
+    else
+        ERR_print_errors_fp(stderr);
+
+    if (ok)
+    {
+        sample.wall_ms = now_ms(CLOCK_MONOTONIC) - wall;
+        sample.cpu_ms = now_ms(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+        sample.resumed = SSL_session_reused(ssl);
+
+        const uint8_t disconnect[] = {0xE0, 0x00};
+        SSL_write(ssl, disconnect, sizeof(disconnect));
+        SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+    close(fd);
+    return ok;
+}
+
+static void report(const char *name, std::vector<Sample> &samples)
+{
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b)
+              { return a.wall_ms < b.wall_ms; });
+    double cpu = 0;
+    size_t resumed = 0;
+    for (auto &sample : samples)
+    {
+        cpu += sample.cpu_ms;
+        resumed += sample.resumed;
+    }
+    printf("%-8s %3zu connects, %3zu resumed, wall ms p50 %.2f p90 %.2f max %.2f, cpu ms avg %.2f\n", name,
+           samples.size(), resumed, samples[samples.size() / 2].wall_ms, samples[samples.size() * 9 / 10].wall_ms,
+           samples.back().wall_ms, cpu / samples.size());
+}
+
+int main(int argc, char **argv)
+{
+    std::string host = "localhost";
+    std::string port = "8883";
+    std::string ca;
+    int count = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value)
+            host = argv[++i];
+        else if (arg == "--port" && has_value)
+            port = argv[++i];
+        else if (arg == "--ca" && has_value)
+            ca = argv[++i];
+        else if (arg == "--count" && has_value)
+            count = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--host <host>] [--port <port>] [--ca <file>] [--count <n>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SSL_CTX *ctx = tls_resuming_context();
+    if (ca.empty() ? SSL_CTX_set_default_verify_paths(ctx) != 1 : SSL_CTX_load_verify_locations(ctx, ca.c_str(), nullptr) != 1)
+    {
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+
+    std::vector<Sample> full, resumed;
+    for (int i = 0; i < count; i++)
+    {
+        Sample sample;
+        tls_forget_session(ctx);
+        if (!mqtt_connect_once(ctx, host, port, sample))
+            return 1;
+        full.push_back(sample);
+    }
+    // the last full connect left a session behind
+    for (int i = 0; i < count; i++)
+    {
+        Sample sample;
+        if (!mqtt_connect_once(ctx, host, port, sample))
+            return 1;
+        resumed.push_back(sample);
+    }
+
+    report("full", full);
+    report("resumed", resumed);
+    return 0;
+}